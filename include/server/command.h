@@ -0,0 +1,125 @@
+/**
+ * This file is part of the microipc distribution (https://github.com/MustafaMalikDev/microipc)
+ * Copyright (c) 2025 Mustafa Malik.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MIPC_SERVER_COMMAND_H_
+#define _MIPC_SERVER_COMMAND_H_
+
+#include "process.h"
+
+#include <stddef.h>
+
+#define MIPC_BATCH_MAX_OPS 64
+#define MIPC_COMMAND_MAX_HANDLES 32
+#define MIPC_BATCH_DELIM ';'
+
+#define MIPC_COMMAND_CREATE 'c'
+#define MIPC_COMMAND_REMOVE 'r'
+#define MIPC_COMMAND_BATCH 'b'
+#define MIPC_COMMAND_STREAM 's'
+#define MIPC_COMMAND_GROUP 'g'
+#define MIPC_COMMAND_VECTOR 'v'
+#define MIPC_COMMAND_LIMIT 'l'
+#define MIPC_COMMAND_ATTACH 'a'
+#define MIPC_COMMAND_SEND 'w'
+#define MIPC_COMMAND_STAMP 't'
+#define MIPC_COMMAND_ROUTE '{'
+
+/* the client connection a server port was registered from */
+struct mipc_command_server_t {
+    uint32_t port;
+    int fd;
+};
+
+/* a client connection bound to one mailbox link, the index is only trusted for its table generation */
+struct mipc_command_handle_t {
+    int fd;
+    uint32_t port;
+    uint32_t pid;
+    int8_t entry;
+    uint32_t generation;
+};
+
+struct mipc_command_op_t {
+    char type;
+    struct mipc_process_request_t request;
+};
+
+/* runs a single command frame of the given length received on the given client */
+void mipc_command_execute(int, char*, size_t);
+
+/*
+    FALSE for a stream or vector frame that doesn't carry exactly its body, a packet
+    is exactly one command so the rest of it will never arrive on that socket
+*/
+int mipc_command_complete(char*, size_t);
+
+/* answers a frame that was not admitted, the body of a stream frame is drained first */
+void mipc_command_reject(int, char*, size_t, const char*);
+
+/* the send to dispatch latency of the stamped frames, printed on shutdown */
+void mipc_command_print_stats(void);
+
+/* forgets everything bound to a client connection that went away */
+void mipc_command_disconnect(int);
+
+/*
+    `b <op>;<op>;...` where every op is a regular command, the results are
+    written back to the client as one '1'/'0' character per op
+*/
+int mipc_command_batch(int, char*);
+
+/*
+    `g <policy>[/msg] <serialised_structure>` joins a service group on the port,
+    policy is rr, least or hash and `/msg` balances every message instead of every link
+*/
+int mipc_command_group(int, char*);
+
+/*
+    `s <length> <serialised_structure>\n<body>` streams a body of any size
+    over an existing mailbox link, only the header line is parsed
+*/
+int mipc_command_stream(int, char*, size_t);
+
+/*
+    `v <length>[,<length>...] <serialised_structure>\n<segment><segment>...` carries
+    the payload as segments that are never joined, the linked server gets them
+    behind the same header line in a single writev
+*/
+int mipc_command_vector(int, char*, size_t);
+
+/*
+    `a <serialised_structure>` binds the connection to its mailbox link (linking it
+    first if needed) and answers `handle: <n>`, or `handle: -1` when it can't
+*/
+int mipc_command_attach(int, char*);
+
+/* `w <handle> <payload>` sends the payload over the link bound with `a` without any lookup */
+int mipc_command_send(int, char*, size_t);
+
+/*
+    `l [key=value,...]` changes the rate limits when sent over the control socket,
+    the client gets the current limits back
+*/
+int mipc_command_limit(int, char*);
+
+/*
+    `t <ns>` carries the client's CLOCK_MONOTONIC_RAW time from right before it sent
+    the frame, answered with `stamp: <ns>` the time the frame took to reach its command
+*/
+int mipc_command_stamp(int, char*);
+
+#endif /* _MIPC_SERVER_COMMAND_H_ */
@@ -20,6 +20,87 @@
 
 #include "process.h"
 
+#include "config.h"
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#define MIPC_STREAM_CHUNK 65536
+#define MIPC_STREAM_MAX (1UL << 30) /* longest stream body a header may announce */
+
+#define MIPC_STREAM_HEADER_MAX 512 /* longest header forwarded in front of a stream body */
+#define MIPC_STREAM_MAX_RELAYS MIPC_MAX_POLL_FDS
+
+/* the payload of a `v` frame, kept by reference on its mailbox until it is delivered */
+struct mipc_dispatch_segments_t {
+    int count;
+    struct iovec iov[MIPC_SEGMENT_MAX];
+};
+
+/* a stream body on its way from one client to another, moved one chunk per event */
+struct mipc_dispatch_relay_t {
+    int active;
+    int src;
+    int dst;
+    int target; /* the receiver the relay was started for, kept to order relays into it */
+    int waiting;
+    int blocked;
+    int respond;
+    int port;
+    int pid;
+    size_t length;
+    size_t remaining; /* body bytes still to read from the sender */
+    size_t pending;   /* bytes in the chunk still to write to the receiver */
+    size_t offset;
+    char* chunk;
+};
+
+/* allocates the stream relay chunks for the given frame size, in the server region when there is one */
+int mipc_dispatch_init(size_t);
+
+/* the queue relays pause and resume client events on */
+void mipc_dispatch_set_queue(int);
+
 int mipc_dispatch_send_msg(int, int, const char*);
 
+/* same as mipc_dispatch_send_msg for a caller that already holds the mailbox */
+int mipc_dispatch_send_mailbox(struct mipc_process_mailbox_t*, const char*);
+
+/*
+    same as mipc_dispatch_send_msg but the payload segments are not copied,
+    they have to stay valid until mipc_dispatch_deliver_segments
+*/
+int mipc_dispatch_send_segments(int, int, const char*, const struct iovec*, int);
+
+/*
+    gathers the header and the mailbox segments into one write to the receiver, then forgets
+    the segments. what the receiver can't take right away is kept on a relay and the sender
+    is answered once it went out
+*/
+int mipc_dispatch_deliver_segments(int, int, int, int, const char*, size_t);
+
+/* every write back to a client goes through here so it can be traced */
+ssize_t mipc_dispatch_write(int, const void*, size_t);
+
+/* same as mipc_dispatch_write for a gather list, never blocks */
+ssize_t mipc_dispatch_writev(int, const struct iovec*, int);
+
+/*
+    starts relaying a stream body of the given length from one client to another,
+    the forwarded header and the first body bytes that came with it are sent first.
+    a negative destination drains the body so it can't be read as commands, the
+    sender is answered once the whole body was delivered
+*/
+int mipc_dispatch_stream(int, int, const char*, size_t, const char*, size_t, size_t, int, int);
+
+/* TRUE while a relay is writing into or waiting for the given receiver */
+int mipc_dispatch_busy(int);
+
+/* moves the next chunk of a relay on a read of its sender or a write of its receiver, TRUE if consumed */
+int mipc_dispatch_stream_event(int, int);
+
+/* drops the relays a closing client sends, relays into it keep draining their senders */
+void mipc_dispatch_stream_disconnect(int);
+
 #endif /* _MIPC_SERVER_DISPATCH_H_ */
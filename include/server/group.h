@@ -0,0 +1,65 @@
+/**
+ * This file is part of the microipc distribution (https://github.com/MustafaMalikDev/microipc)
+ * Copyright (c) 2025 Mustafa Malik.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MIPC_SERVER_GROUP_H_
+#define _MIPC_SERVER_GROUP_H_
+
+#include "config.h"
+#include "process.h"
+
+#include <stdint.h>
+
+/* how a member is picked for a client */
+#define MIPC_GROUP_ROUND_ROBIN 0
+#define MIPC_GROUP_LEAST_OUTSTANDING 1 /* fewest linked clients, then fewest routed messages */
+#define MIPC_GROUP_AFFINITY 2          /* rendezvous (consistent) hashing on the client pid */
+
+/* when a member is picked */
+#define MIPC_GROUP_PER_LINK 0
+#define MIPC_GROUP_PER_MESSAGE 1
+
+struct mipc_group_member_t {
+    uint32_t pid;
+    int fd;
+    uint64_t routed;
+};
+
+/* several server processes registered on the same port */
+struct mipc_group_t {
+    uint32_t port;
+    uint8_t policy;
+    uint8_t granularity;
+    uint8_t count;
+    uint32_t next;
+    struct mipc_group_member_t members[MIPC_MAX_POLL_FDS];
+};
+
+int mipc_group_join(const struct mipc_process_request_t, int, int, int);
+
+/* removes a member, its links are moved to the remaining members */
+int mipc_group_leave(uint32_t, uint32_t);
+
+/* removes every member registered from the given connection */
+void mipc_group_disconnect(int);
+
+struct mipc_group_t* mipc_group_find(uint32_t);
+
+struct mipc_group_member_t* mipc_group_member(struct mipc_group_t*, uint32_t);
+
+struct mipc_group_member_t* mipc_group_pick(struct mipc_group_t*, uint32_t);
+
+#endif /* _MIPC_SERVER_GROUP_H_ */
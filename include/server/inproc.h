@@ -0,0 +1,65 @@
+/**
+ * This file is part of the microipc distribution (https://github.com/MustafaMalikDev/microipc)
+ * Copyright (c) 2025 Mustafa Malik.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MIPC_SERVER_INPROC_H_
+#define _MIPC_SERVER_INPROC_H_
+
+#include "config.h"
+#include "process.h"
+#include "queue.h"
+
+/*
+    the same register/link/send/remove semantics as the socket "Kernel",
+    for producers and consumers that are threads of one process
+*/
+
+/* a registered server port, every linked client pushes into its inbox */
+struct mipc_inproc_endpoint_t {
+    uint32_t port;
+    uint32_t pid;
+    struct mipc_queue_mpsc_t inbox;
+};
+
+/* a mailbox link, the server pushes responses for one client into reply */
+struct mipc_inproc_link_t {
+    uint32_t port;
+    uint32_t pid;
+    struct mipc_queue_spsc_t reply;
+};
+
+/* `c <serialised_structure>` */
+int mipc_inproc_register(const struct mipc_process_request_t);
+
+/* first `<serialised_structure>` */
+int mipc_inproc_link(const struct mipc_process_request_t);
+
+/* following `<serialised_structure>`, the message goes into the server inbox */
+int mipc_inproc_send(const struct mipc_process_request_t);
+
+/* server side, the timeout is in microseconds (0 blocks until a message arrives) */
+int mipc_inproc_recv(uint32_t, struct mipc_process_request_t*, uint32_t);
+
+/* server side, writes a response to the client on the (port, pid) link */
+int mipc_inproc_reply(uint32_t, uint32_t, const char*);
+
+/* client side, reads a response from the (port, pid) link */
+int mipc_inproc_recv_reply(uint32_t, uint32_t, struct mipc_process_request_t*, uint32_t);
+
+/* `r <serialised_structure>` */
+void mipc_inproc_remove(const struct mipc_process_request_t);
+
+#endif /* _MIPC_SERVER_INPROC_H_ */
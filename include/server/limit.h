@@ -0,0 +1,95 @@
+/**
+ * This file is part of the microipc distribution (https://github.com/MustafaMalikDev/microipc)
+ * Copyright (c) 2025 Mustafa Malik.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MIPC_SERVER_LIMIT_H_
+#define _MIPC_SERVER_LIMIT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* what happens to a connection that ran out of budget */
+#define MIPC_LIMIT_REJECT 0 /* its frames are read and answered with a rejection (default) */
+#define MIPC_LIMIT_DEFER 1  /* it is not read again until the budget refills */
+
+#define MIPC_LIMIT_MAX_CONNS 64
+#define MIPC_LIMIT_MAX_PORTS 16
+
+/* every rate is per second and allows a burst of one second worth, 0 means unlimited */
+struct mipc_limit_config_t {
+    uint32_t conn_msgs;
+    uint32_t conn_bytes;
+    uint32_t port_msgs;
+    uint32_t port_bytes;
+    uint32_t conns; /* open client connections at once */
+    int mode;
+};
+
+struct mipc_limit_bucket_t {
+    double tokens;
+    uint64_t last;
+};
+
+struct mipc_limit_conn_t {
+    int fd;
+    int used;
+    int control; /* accepted on the control socket, may change the limits */
+    struct mipc_limit_bucket_t msgs;
+    struct mipc_limit_bucket_t bytes;
+};
+
+struct mipc_limit_port_t {
+    uint32_t port;
+    struct mipc_limit_bucket_t msgs;
+    struct mipc_limit_bucket_t bytes;
+};
+
+/*
+    `key=value,...` with the keys conn_msgs, conn_bytes, port_msgs, port_bytes,
+    conns and mode (reject or defer), keys that are left out keep their value
+*/
+int mipc_limit_configure(const char*);
+
+/* the current limits in the same `key=value,...` form */
+int mipc_limit_describe(char*, size_t);
+
+int mipc_limit_mode(void);
+
+/* a new client connection, FALSE when it would go over the connection cap */
+int mipc_limit_open(int);
+
+void mipc_limit_close(int);
+
+/* lets a connection from the control socket change the limits, it is kept out of the connection cap */
+void mipc_limit_authorise(int);
+
+int mipc_limit_authorised(int);
+
+/* 0 when the connection may go on, otherwise the nanoseconds until its budget covers the frame */
+uint64_t mipc_limit_conn_admit(int, size_t);
+
+/* FALSE when the port is over its budget or no slot is left to track it */
+int mipc_limit_port_admit(uint32_t, size_t);
+
+/* forgets the budget of a port whose process went away, its slot can be reused */
+void mipc_limit_port_release(uint32_t);
+
+/* the fast answer to a frame that was not admitted, padded like every other response */
+void mipc_limit_reject(int, const char*);
+
+void mipc_limit_print_stats(void);
+
+#endif /* _MIPC_SERVER_LIMIT_H_ */
@@ -0,0 +1,57 @@
+/**
+ * This file is part of the microipc distribution (https://github.com/MustafaMalikDev/microipc)
+ * Copyright (c) 2025 Mustafa Malik.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MIPC_SERVER_PACKET_H_
+#define _MIPC_SERVER_PACKET_H_
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/* most messages pulled off a packet socket per wakeup */
+#define MIPC_PACKET_BATCH 16
+#define MIPC_PACKET_MAX_CONNS 64
+
+/*
+    called once per message with its exact length, a length of 0 means the
+    connection (or the datagram peer) behind the fd went away
+*/
+typedef void (*mipc_packet_handler_fn)(int, char*, ssize_t);
+
+/*
+    binds a message preserving listener, SOCK_SEQPACKET where the platform has it
+    and SOCK_DGRAM otherwise, every frame is at most size - 1 bytes,
+    returns the listener fd or -1
+*/
+int mipc_packet_listen(const char*, int);
+
+/* TRUE when the listener hands out connections (SOCK_SEQPACKET) that have to be accepted */
+int mipc_packet_connected(void);
+
+/* remembers an accepted SOCK_SEQPACKET connection, FALSE when there is no room for it */
+int mipc_packet_adopt(int);
+
+/* TRUE for an accepted packet connection */
+int mipc_packet_owns(int);
+
+void mipc_packet_release(int);
+
+/* drains up to MIPC_PACKET_BATCH messages from a packet connection or the datagram listener */
+int mipc_packet_recv(int, mipc_packet_handler_fn);
+
+void mipc_packet_close(void);
+
+#endif /* _MIPC_SERVER_PACKET_H_ */
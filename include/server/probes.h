@@ -0,0 +1,43 @@
+/**
+ * This file is part of the microipc distribution (https://github.com/MustafaMalikDev/microipc)
+ * Copyright (c) 2025 Mustafa Malik.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MIPC_SERVER_PROBES_H_
+#define _MIPC_SERVER_PROBES_H_
+
+// clang-format off
+
+/*
+    without USDT=1 every probe compiles to nothing, with it a probe is a
+    single nop until dtrace attaches to it. the arguments (a strlen for the
+    parse probes) are only evaluated behind the is-enabled check
+*/
+#ifdef MIPC_USE_USDT
+#   include "mipc_probes.h"
+#   define MIPC_PROBE(name, conn, port, pid, size) \
+        do { \
+            if (MIPC_##name##_ENABLED()) { \
+                MIPC_##name((int)(conn), (unsigned int)(port), (unsigned int)(pid), (long)(size)); \
+            } \
+        } while (0)
+#else
+    /* sizeof never evaluates its operand, the arguments only count as used */
+#   define MIPC_PROBE(name, conn, port, pid, size) ((void)sizeof((conn) + (port) + (pid) + (size)))
+#endif
+
+// clang-format on
+
+#endif /* _MIPC_SERVER_PROBES_H_ */
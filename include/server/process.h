@@ -18,6 +18,13 @@
 #ifndef _MIPC_SERVER_PROCESS_H_
 #define _MIPC_SERVER_PROCESS_H_
 
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/* most payload segments in one `v` frame */
+#define MIPC_SEGMENT_MAX 16
+
 #define MIPC_EMPTY_PROCESS() (struct mipc_process_request_t){.message = 0, .recv = 0, .pid = 0, .port = 0}
 
 struct mipc_process_request_t {
@@ -39,4 +46,16 @@ int mipc_process_is_empty(const struct mipc_process_request_t);
 
 struct mipc_process_request_t mipc_process_deserialise(const char*);
 
+/*
+    client side, sends a `v` frame on a connected socket: the request becomes the
+    header line and the segments go out as they are through one sendmsg
+*/
+ssize_t mipc_process_sendv(int, const struct mipc_process_request_t*, const struct iovec*, int);
+
+/*
+    client side, sends a `t` frame stamped with the current time and waits for the
+    answer, returns the nanoseconds it took the frame to reach its command or -1
+*/
+int64_t mipc_process_stamp(int);
+
 #endif /* _MIPC_SERVER_PROCESS_H_ */
@@ -0,0 +1,76 @@
+/**
+ * This file is part of the microipc distribution (https://github.com/MustafaMalikDev/microipc)
+ * Copyright (c) 2025 Mustafa Malik.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MIPC_SERVER_QUEUE_H_
+#define _MIPC_SERVER_QUEUE_H_
+
+#include <stdint.h>
+
+#define MIPC_QUEUE_DEPTH 64 /* must be a power of two */
+#define MIPC_QUEUE_CACHE_LINE 128
+
+#define MIPC_QUEUE_ALIGNED __attribute__((aligned(MIPC_QUEUE_CACHE_LINE)))
+
+struct mipc_queue_msg_t {
+    char message[255];
+    uint32_t pid;
+    uint32_t port;
+};
+
+/*
+    blocking waits park on `seq` through __ulock_wait (the darwin futex),
+    producers only pay for the wake syscall when someone is actually parked
+*/
+struct mipc_queue_event_t {
+    uint32_t seq;
+    uint32_t waiters;
+};
+
+/* single producer, single consumer: used for replies on a mailbox link */
+struct mipc_queue_spsc_t {
+    MIPC_QUEUE_ALIGNED uint32_t head; /* owned by the consumer */
+    MIPC_QUEUE_ALIGNED uint32_t tail; /* owned by the producer */
+    MIPC_QUEUE_ALIGNED struct mipc_queue_event_t event;
+    struct mipc_queue_msg_t slots[MIPC_QUEUE_DEPTH];
+};
+
+/* multiple producer, single consumer: used for a server's inbox */
+struct mipc_queue_mpsc_t {
+    MIPC_QUEUE_ALIGNED uint32_t head; /* owned by the consumer */
+    MIPC_QUEUE_ALIGNED uint32_t tail; /* claimed by producers */
+    MIPC_QUEUE_ALIGNED struct mipc_queue_event_t event;
+    uint32_t seq[MIPC_QUEUE_DEPTH];
+    struct mipc_queue_msg_t slots[MIPC_QUEUE_DEPTH];
+};
+
+void mipc_queue_spsc_init(struct mipc_queue_spsc_t*);
+
+int mipc_queue_spsc_push(struct mipc_queue_spsc_t*, const struct mipc_queue_msg_t*);
+
+int mipc_queue_spsc_pop(struct mipc_queue_spsc_t*, struct mipc_queue_msg_t*);
+
+int mipc_queue_spsc_pop_wait(struct mipc_queue_spsc_t*, struct mipc_queue_msg_t*, uint32_t);
+
+void mipc_queue_mpsc_init(struct mipc_queue_mpsc_t*);
+
+int mipc_queue_mpsc_push(struct mipc_queue_mpsc_t*, const struct mipc_queue_msg_t*);
+
+int mipc_queue_mpsc_pop(struct mipc_queue_mpsc_t*, struct mipc_queue_msg_t*);
+
+int mipc_queue_mpsc_pop_wait(struct mipc_queue_mpsc_t*, struct mipc_queue_msg_t*, uint32_t);
+
+#endif /* _MIPC_SERVER_QUEUE_H_ */
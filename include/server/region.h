@@ -0,0 +1,48 @@
+/**
+ * This file is part of the microipc distribution (https://github.com/MustafaMalikDev/microipc)
+ * Copyright (c) 2025 Mustafa Malik.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MIPC_SERVER_REGION_H_
+#define _MIPC_SERVER_REGION_H_
+
+#include <stddef.h>
+
+#define MIPC_REGION_HUGEPAGES 0x1 /* ask for superpages, falls back to regular pages */
+#define MIPC_REGION_PREFAULT 0x2  /* touch every page up front */
+#define MIPC_REGION_LOCK 0x4      /* mlock the region so it can never be paged out */
+
+#define MIPC_REGION_DEFAULT_SIZE (8 << 20)
+#define MIPC_REGION_ALIGN 128
+
+/*
+    one region sized at startup that holds the process table, the connection buffers
+    and the message buffers, so they take no page faults and need no allocator calls
+    once the server runs. the small fixed size tables of the other modules are static
+    and may still fault on first use. must be set up before anything else is started
+*/
+int mipc_region_init(size_t, int);
+
+/* carves zeroed memory out of the region, or calloc's it when there is no region or it is exhausted */
+void* mipc_region_alloc(size_t);
+
+/* frees memory from mipc_region_alloc that did not come out of the region */
+void mipc_region_free(void*);
+
+int mipc_region_active(void);
+
+void mipc_region_destroy(void);
+
+#endif /* _MIPC_SERVER_REGION_H_ */
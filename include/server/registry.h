@@ -0,0 +1,70 @@
+/**
+ * This file is part of the microipc distribution (https://github.com/MustafaMalikDev/microipc)
+ * Copyright (c) 2025 Mustafa Malik.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MIPC_SERVER_REGISTRY_H_
+#define _MIPC_SERVER_REGISTRY_H_
+
+#include "config.h"
+
+#include <stdint.h>
+
+#define MIPC_REGISTRY_NAME "/mipc.registry"
+#define MIPC_REGISTRY_MAGIC 0x4d495043 /* MIPC */
+
+struct mipc_table_t;
+struct mipc_group_t;
+
+struct mipc_registry_slot_t {
+    uint32_t port;
+    uint32_t pid;
+};
+
+/*
+    read-only snapshot of the process table and mailbox queues in shared memory,
+    `seq` is odd while the "Kernel" is rewriting it (seqlock), so a reader copies
+    the slots and retries if `seq` changed or was odd
+*/
+struct mipc_registry_t {
+    uint32_t magic;
+    uint32_t seq;
+    struct mipc_registry_slot_t processes[MIPC_MAX_POLL_FDS]; /* registered (port, pid) */
+    struct mipc_registry_slot_t links[MIPC_MAX_POLL_FDS];     /* linked (server port, client pid) */
+
+    /* service group members (port, pid), groups never go through the process table */
+    struct mipc_registry_slot_t members[MIPC_MAX_POLL_FDS * MIPC_MAX_POLL_FDS];
+};
+
+/* "Kernel" side */
+int mipc_registry_create(void);
+
+void mipc_registry_publish(const struct mipc_table_t*);
+
+/* rewrites the member slots from the given groups */
+void mipc_registry_publish_groups(const struct mipc_group_t*, uint8_t);
+
+void mipc_registry_destroy(void);
+
+/* client side, no syscalls after attaching */
+int mipc_registry_attach(void);
+
+int mipc_registry_contains(uint32_t);
+
+int mipc_registry_linked(uint32_t, uint32_t);
+
+void mipc_registry_detach(void);
+
+#endif /* _MIPC_SERVER_REGISTRY_H_ */
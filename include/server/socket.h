@@ -18,8 +18,33 @@
 #ifndef _MIPC_SERVER_SOCKET_H_
 #define _MIPC_SERVER_SOCKET_H_
 
+/* how the event loop waits for the next kernel event */
+#define MIPC_POLL_BLOCK 0    /* sleep in kevent until something happens (default) */
+#define MIPC_POLL_BUSY 1     /* never sleep, spin on a zero timeout kevent */
+#define MIPC_POLL_ADAPTIVE 2 /* spin for the given budget of empty polls, then sleep */
+
+#define MIPC_POLL_DEFAULT_SPIN 10000
+
 int mipc_socket_create(const char*, int);
 
+/* must be called before mipc_socket_start, the spin budget is only used by MIPC_POLL_ADAPTIVE */
+int mipc_socket_set_poll(int, unsigned int);
+
+/* cpu (-1 to leave it to the scheduler) and round robin priority (0 to keep the default) of the loop thread */
+int mipc_socket_set_affinity(int, int);
+
+/*
+    must be called before mipc_socket_start, also listens on the given path with
+    SOCK_SEQPACKET (SOCK_DGRAM where AF_UNIX has no SEQPACKET) so every message is one packet
+*/
+int mipc_socket_set_packet(const char*);
+
+/*
+    must be called before mipc_socket_start, also listens on the given path for
+    connections that may change the limits with `l`, only the server's user can connect
+*/
+int mipc_socket_set_control(const char*);
+
 int mipc_socket_start(void);
 
 void mipc_socket_stop(int);
@@ -42,13 +42,19 @@ struct mipc_table_t {
     struct mipc_table_mailbox_entry mail_entry;
 };
 
+/* moves the tables into the server region when there is one and publishes them */
+int mipc_table_init(void);
+
+/* bumped on every change to the tables, a mailbox index is only valid for the generation it was found in */
+uint32_t mipc_table_generation(void);
+
 int8_t mipc_table_contains(const struct mipc_process_request_t);
 
-void mipc_table_insert(const struct mipc_process_request_t);
+int mipc_table_insert(const struct mipc_process_request_t);
 
 void mipc_table_update(const struct mipc_process_request_t);
 
-void mipc_table_remove(const struct mipc_process_request_t);
+int mipc_table_remove(const struct mipc_process_request_t);
 
 struct mipc_process_mailbox_t* mipc_table_get_mailbox(int, int);
 
@@ -62,6 +68,22 @@ void mipc_table_map_to_queue(const struct mipc_process_request_t);
 
 void mipc_table_destroy_queue(const struct mipc_process_request_t);
 
+/* links a server and a client directly, for servers that don't sit in the process table */
+int8_t mipc_table_link_queue(const struct mipc_process_request_t, const struct mipc_process_request_t);
+
+/* moves an existing mailbox queue to another server without touching the client */
+void mipc_table_rebind_queue(uint8_t, const struct mipc_process_request_t);
+
+/*
+    same as mipc_table_rebind_queue for a server picked per message, the queue keeps its
+    index so the generation stays and the registry isn't published again
+*/
+void mipc_table_pick_queue(uint8_t, const struct mipc_process_request_t);
+
+struct mipc_process_mailbox_t* mipc_table_get_queue(uint8_t);
+
+uint8_t mipc_table_queue_count(uint32_t, uint32_t);
+
 void mipc_table_print_queue(void);
 
 #endif /* _MIPC_SERVER_TABLE_H_ */
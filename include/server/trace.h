@@ -0,0 +1,51 @@
+/**
+ * This file is part of the microipc distribution (https://github.com/MustafaMalikDev/microipc)
+ * Copyright (c) 2025 Mustafa Malik.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MIPC_SERVER_TRACE_H_
+#define _MIPC_SERVER_TRACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MIPC_TRACE_MAGIC "MIPCTRC1"
+#define MIPC_TRACE_MAGIC_LEN 8
+#define MIPC_TRACE_BUFFER (1 << 20)
+
+/* kind of a trace record */
+#define MIPC_TRACE_OPEN 'o'  /* client connected, no payload */
+#define MIPC_TRACE_RECV 'r'  /* raw bytes read from a client, payload follows */
+#define MIPC_TRACE_SEND 's'  /* bytes written to a client, only the length is kept */
+#define MIPC_TRACE_CLOSE 'x' /* client disconnected, no payload */
+
+/*
+    a trace file is MIPC_TRACE_MAGIC followed by records,
+    every record is this header followed by `len` payload bytes for MIPC_TRACE_RECV
+*/
+struct mipc_trace_record_t {
+    uint64_t time; /* nanoseconds since the capture started */
+    uint32_t conn; /* the client connection */
+    uint32_t len;
+    uint8_t type;
+} __attribute__((packed));
+
+int mipc_trace_open(const char*);
+
+void mipc_trace_record(uint8_t, int, const void*, size_t);
+
+void mipc_trace_close(void);
+
+#endif /* _MIPC_SERVER_TRACE_H_ */
@@ -0,0 +1,32 @@
+/**
+ * This file is part of the microipc distribution (https://github.com/MustafaMalikDev/microipc)
+ * Copyright (c) 2025 Mustafa Malik.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MIPC_TIMEUTIL_H_
+#define _MIPC_TIMEUTIL_H_
+
+#include <stdint.h>
+
+#define MIPC_NS_PER_SEC 1000000000ULL
+#define MIPC_NS_PER_USEC 1000ULL
+
+/* monotonic clock in nanoseconds, unaffected by wall clock changes */
+uint64_t timenow(void);
+
+/* sleeps until the given timenow() value is reached */
+void timesleepuntil(uint64_t);
+
+#endif /* _MIPC_TIMEUTIL_H_ */
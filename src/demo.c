@@ -18,8 +18,12 @@
 #define MIPC_USE_STD
 
 #include "config.h"
+#include "strutil.h"
+#include "server/limit.h"
 #include "server/process.h"
+#include "server/region.h"
 #include "server/socket.h"
+#include "server/trace.h"
 
 int main(void) {
     signal(SIGINT, mipc_socket_stop);
@@ -29,13 +33,78 @@ int main(void) {
     // printf("%d\n", res.pid);
     // printf("%d\n", res.port);
 
-    int res = mipc_socket_create("/tmp/mipc.sock", 255);
+    /* MIPC_REGION=<megabytes> preallocates all server memory, MIPC_REGION_LOCK=1 also pins it in RAM */
+    const char* region = getenv("MIPC_REGION");
+
+    if (region) {
+        int flags = MIPC_REGION_HUGEPAGES | MIPC_REGION_PREFAULT;
+
+        if (getenv("MIPC_REGION_LOCK")) {
+            flags |= MIPC_REGION_LOCK;
+        }
+
+        if (!mipc_region_init((size_t)atoi(region) << 20, flags)) {
+            printerr("(0) failed to map server region");
+        }
+    }
+
+    /* MIPC_TRACE=<file> captures every frame for mipc-replay */
+    const char* trace = getenv("MIPC_TRACE");
+
+    if (trace && !mipc_trace_open(trace)) {
+        printerr("(0) failed to open trace file");
+    }
+
+    int res = mipc_socket_create("/tmp/mipc.sock", 4096);
 
     if (!res) {
         printerr("(1) failed to create socket");
         exit(EXIT_FAILURE);
     }
 
+    /* MIPC_POLL=block|busy|adaptive[:spin], MIPC_CPU=<cpu>, MIPC_PRIORITY=<priority> */
+    const char* poll = getenv("MIPC_POLL");
+    const char* cpu = getenv("MIPC_CPU");
+    const char* priority = getenv("MIPC_PRIORITY");
+
+    if (poll) {
+        int mode = MIPC_POLL_BLOCK;
+        const char* spin = strchr(poll, ':');
+
+        if (strstartswith("busy", poll)) {
+            mode = MIPC_POLL_BUSY;
+        } else if (strstartswith("adaptive", poll)) {
+            mode = MIPC_POLL_ADAPTIVE;
+        }
+
+        mipc_socket_set_poll(mode, spin ? atoi(spin + 1) : 0);
+    }
+
+    if (cpu || priority) {
+        mipc_socket_set_affinity(cpu ? atoi(cpu) : -1, priority ? atoi(priority) : 0);
+    }
+
+    /* MIPC_PACKET=<path> adds a message preserving listener next to /tmp/mipc.sock */
+    const char* packet = getenv("MIPC_PACKET");
+
+    if (packet && !mipc_socket_set_packet(packet)) {
+        printerr("(1) failed to configure packet listener");
+    }
+
+    /* MIPC_LIMIT=<key=value,...> sets the rate limits up front, `l` changes them at runtime */
+    const char* limit = getenv("MIPC_LIMIT");
+
+    if (limit && !mipc_limit_configure(limit)) {
+        printerr("(1) failed to configure limits");
+    }
+
+    /* MIPC_CONTROL=<path> adds the socket `l` can change the limits from */
+    const char* control = getenv("MIPC_CONTROL");
+
+    if (control && !mipc_socket_set_control(control)) {
+        printerr("(1) failed to configure control listener");
+    }
+
     res = mipc_socket_start();
 
     if (!res) {
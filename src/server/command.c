@@ -0,0 +1,898 @@
+/**
+ * This file is part of the microipc distribution (https://github.com/MustafaMalikDev/microipc)
+ * Copyright (c) 2025 Mustafa Malik.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIPC_USE_LIBS
+#define MIPC_USE_STD
+
+#include "server/command.h"
+#include "server/dispatch.h"
+#include "server/group.h"
+#include "server/limit.h"
+#include "server/probes.h"
+#include "server/table.h"
+
+#include "config.h"
+#include "strutil.h"
+#include "timeutil.h"
+
+#include <string.h>
+
+static struct mipc_command_server_t g_servers[MIPC_MAX_POLL_FDS];
+static struct mipc_command_handle_t g_handles[MIPC_COMMAND_MAX_HANDLES];
+
+/* time from a client stamping a `t` frame to the command running on it */
+static uint64_t g_stamp_count = 0;
+static uint64_t g_stamp_total = 0;
+static uint64_t g_stamp_max = 0;
+
+/* a port registered again takes over its old entry so lookups never find a stale connection */
+static void g_mipc_command_bind_server(uint32_t port, int fd) {
+    struct mipc_command_server_t* slot = NULL;
+
+    for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
+        if (g_servers[i].port == port) {
+            slot = &g_servers[i];
+            break;
+        }
+
+        if (!g_servers[i].port && !slot) {
+            slot = &g_servers[i];
+        }
+    }
+
+    if (slot) {
+        slot->port = port;
+        slot->fd = fd;
+    }
+}
+
+static void g_mipc_command_unbind_server(uint32_t port) {
+    for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
+        if (g_servers[i].port == port) {
+            memset(&g_servers[i], 0, sizeof(struct mipc_command_server_t));
+        }
+    }
+
+    mipc_limit_port_release(port);
+}
+
+static int g_mipc_command_server_fd(uint32_t port, uint32_t pid) {
+    struct mipc_group_t* group = mipc_group_find(port);
+
+    if (group) {
+        int8_t entry = mipc_table_queue_contains_both(port, pid);
+        struct mipc_process_mailbox_t* mailbox = entry == -1 ? NULL : mipc_table_get_queue(entry);
+        struct mipc_group_member_t* member = mailbox ? mipc_group_member(group, mailbox->first.pid) : NULL;
+
+        return member ? member->fd : -1;
+    }
+
+    for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
+        if (g_servers[i].port == port) {
+            return g_servers[i].fd;
+        }
+    }
+
+    return -1;
+}
+
+/*
+    a frame whose framing can't be trusted leaves unknown bytes on the socket,
+    the connection is shut down so they are never run as commands
+*/
+static void g_mipc_command_drop(int fd, const char* reason) {
+    printerr(reason);
+    shutdown(fd, SHUT_RDWR);
+}
+
+/* the rest of a stream body is still on the socket and must not be read as commands */
+static void g_mipc_command_drain(int fd, const char* body, size_t body_len, unsigned long length) {
+    if (!mipc_dispatch_stream(fd, -1, "", 0, body, body_len, length, 0, 0)) {
+        g_mipc_command_drop(fd, "cannot drain stream body, dropping client");
+    }
+}
+
+/* `s <length> ...`, FALSE for a missing, signed or oversized length */
+static int g_mipc_command_stream_length(char* frame, unsigned long* length, char** rest) {
+    char* digits = frame + 1;
+
+    while (*digits == ' ') {
+        digits++;
+    }
+
+    /* strtoul would take a sign, "-1" must not turn into a body that never ends */
+    if (*digits < '0' || *digits > '9') {
+        return FALSE;
+    }
+
+    *length = strtoul(digits, rest, 10);
+    return *length <= MIPC_STREAM_MAX;
+}
+
+static struct mipc_process_request_t g_mipc_command_parse(int fd, char* body) {
+    MIPC_PROBE(PARSE_START, fd, 0, 0, strlen(body));
+    struct mipc_process_request_t request = mipc_process_deserialise(body);
+    MIPC_PROBE(PARSE_END, fd, request.port, request.pid, strlen(request.message));
+
+    return request;
+}
+
+static int g_mipc_command_create(int fd, const struct mipc_process_request_t request) {
+    if (mipc_group_find(request.port)) {
+        printerr("cannot insert a process on a service group port");
+        return FALSE;
+    }
+
+    if (!mipc_table_insert(request)) {
+        return FALSE;
+    }
+
+    g_mipc_command_bind_server(request.port, fd);
+    return TRUE;
+}
+
+static void g_mipc_command_deliver_mailbox(int fd, struct mipc_process_mailbox_t* mailbox, int batched) {
+    println(mailbox->first.message);
+    MIPC_PROBE(DELIVER, fd, mailbox->first.port, mailbox->second.pid, strlen(mailbox->first.message));
+
+    if (!batched) {
+        mipc_dispatch_write(fd, mailbox->second.message, 255);
+    }
+}
+
+static void g_mipc_command_deliver(int fd, int port, int pid, int batched) {
+    struct mipc_process_mailbox_t* mailbox = mipc_table_get_mailbox(port, pid);
+
+    if (mailbox) {
+        g_mipc_command_deliver_mailbox(fd, mailbox, batched);
+    }
+}
+
+static void g_mipc_command_respond(int fd, const char* message) {
+    char response[255];
+
+    memset(response, 0, 255);
+    strncpy(response, message, 254);
+
+    mipc_dispatch_write(fd, response, 255);
+}
+
+/* a port over its budget answers with a rejection instead of delivering, batched ops just fail */
+static int g_mipc_command_admit(int fd, int port, size_t bytes, int batched) {
+    if (mipc_limit_port_admit(port, bytes)) {
+        return TRUE;
+    }
+
+    if (!batched) {
+        mipc_limit_reject(fd, "port over its rate limit");
+    }
+
+    return FALSE;
+}
+
+/* same as a regular route, except the server end of the link is picked from the group members */
+static int g_mipc_command_route_group(int fd,
+                                      struct mipc_group_t* group,
+                                      const struct mipc_process_request_t request,
+                                      int batched) {
+    int port = request.port;
+    int pid = request.pid;
+
+    int8_t entry = mipc_table_queue_contains_both(port, pid);
+    MIPC_PROBE(TABLE_LOOKUP, fd, port, pid, entry);
+
+    struct mipc_group_member_t* member = NULL;
+    struct mipc_process_request_t server = MIPC_EMPTY_PROCESS();
+    server.port = port;
+
+    if (entry == -1) {
+        member = mipc_group_pick(group, pid);
+        if (!member) {
+            return FALSE;
+        }
+
+        server.pid = member->pid;
+        if (mipc_table_link_queue(server, request) == -1) {
+            return FALSE;
+        }
+
+        if (!batched) {
+            mipc_table_print_queue();
+        }
+
+        return TRUE;
+    }
+
+    if (!g_mipc_command_admit(fd, port, strlen(request.message), batched)) {
+        return FALSE;
+    }
+
+    struct mipc_process_mailbox_t* mailbox = mipc_table_get_queue(entry);
+
+    if (group->granularity == MIPC_GROUP_PER_MESSAGE) {
+        member = mipc_group_pick(group, pid);
+
+        if (member && member->pid != mailbox->first.pid) {
+            server.pid = member->pid;
+            mipc_table_pick_queue(entry, server);
+        }
+    } else {
+        member = mipc_group_member(group, mailbox->first.pid);
+    }
+
+    MIPC_PROBE(ENQUEUE, fd, port, pid, strlen(request.message));
+
+    if (!mipc_dispatch_send_msg(port, pid, request.message)) {
+        return FALSE;
+    }
+
+    if (member) {
+        member->routed++;
+    }
+
+    g_mipc_command_deliver(fd, port, pid, batched);
+    return TRUE;
+}
+
+/*
+    a request to an existing port either creates the mailbox queue (first time)
+    or sends the message through it, batched requests don't print or respond
+*/
+static int g_mipc_command_route(int fd, const struct mipc_process_request_t request, int batched) {
+    struct mipc_process_request_t target = MIPC_EMPTY_PROCESS();
+    target.port = request.port;
+
+    int port = target.port;
+    int pid = request.pid;
+
+    struct mipc_group_t* group = mipc_group_find(port);
+    if (group) {
+        return g_mipc_command_route_group(fd, group, request, batched);
+    }
+
+    if (mipc_table_contains(target) == -1) {
+        MIPC_PROBE(TABLE_LOOKUP, fd, port, pid, -1);
+        return FALSE;
+    }
+
+    int8_t entry = mipc_table_queue_contains_both(port, pid);
+    MIPC_PROBE(TABLE_LOOKUP, fd, port, pid, entry);
+
+    if (entry == -1) {
+        mipc_table_shift_to_queue(target);
+        mipc_table_map_to_queue(request);
+
+        if (!batched) {
+            mipc_table_print_queue();
+        }
+
+        return mipc_table_queue_contains_both(port, pid) != -1;
+    }
+
+    if (!g_mipc_command_admit(fd, port, strlen(request.message), batched)) {
+        return FALSE;
+    }
+
+    /* if they exist and are mapped, let's send some messages */
+    MIPC_PROBE(ENQUEUE, fd, port, pid, strlen(request.message));
+
+    if (!mipc_dispatch_send_msg(port, pid, request.message)) {
+        return FALSE;
+    }
+
+    g_mipc_command_deliver(fd, port, pid, batched);
+    return TRUE;
+}
+
+static int g_mipc_command_remove(const struct mipc_process_request_t request) {
+    /* a group member leaving keeps the group's links alive on the other members */
+    if (mipc_group_leave(request.port, request.pid)) {
+        return TRUE;
+    }
+
+    int removed = mipc_table_remove(request);
+
+    /* a linked server only lives in the mailbox queues, destroying them removes its port too */
+    if (mipc_table_queue_contains(request)) {
+        mipc_table_destroy_queue(request);
+        removed = TRUE;
+    }
+
+    if (removed) {
+        g_mipc_command_unbind_server(request.port);
+    }
+
+    return removed;
+}
+
+void mipc_command_execute(int fd, char* frame, size_t len) {
+    /* a stream body is binary, it must be routed before anything trims the frame */
+    if (len && *frame == MIPC_COMMAND_STREAM) {
+        mipc_command_stream(fd, frame, len);
+        return;
+    }
+
+    if (len && *frame == MIPC_COMMAND_VECTOR) {
+        mipc_command_vector(fd, frame, len);
+        return;
+    }
+
+    /* the fast path, the payload is taken as it is and nothing is parsed but the handle */
+    if (len && *frame == MIPC_COMMAND_SEND) {
+        mipc_command_send(fd, frame, len);
+        return;
+    }
+
+    const char* message = strtrim(frame);
+    const char* copy = message;
+    struct mipc_process_request_t request;
+
+    if (*message == MIPC_COMMAND_CREATE) {
+        request = g_mipc_command_parse(fd, strtrim((char*)++copy));
+        g_mipc_command_create(fd, request);
+    }
+
+    if (*message == MIPC_COMMAND_REMOVE) {
+        request = g_mipc_command_parse(fd, strtrim((char*)++copy));
+        g_mipc_command_remove(request);
+        mipc_table_print_queue();
+    }
+
+    if (*message == MIPC_COMMAND_GROUP) {
+        mipc_command_group(fd, (char*)++copy);
+    }
+
+    if (*message == MIPC_COMMAND_BATCH) {
+        mipc_command_batch(fd, (char*)++copy);
+    }
+
+    if (*message == MIPC_COMMAND_LIMIT) {
+        mipc_command_limit(fd, (char*)++copy);
+    }
+
+    if (*message == MIPC_COMMAND_STAMP) {
+        mipc_command_stamp(fd, (char*)++copy);
+    }
+
+    if (*message == MIPC_COMMAND_ATTACH) {
+        mipc_command_attach(fd, (char*)++copy);
+    }
+
+    if (*message == MIPC_COMMAND_ROUTE) {
+        request = g_mipc_command_parse(fd, strtrim((char*)message));
+        g_mipc_command_route(fd, request, FALSE);
+    }
+}
+
+int mipc_command_batch(int fd, char* frame) {
+    struct mipc_command_op_t ops[MIPC_BATCH_MAX_OPS];
+    char results[MIPC_BATCH_MAX_OPS];
+    char* cursor = frame;
+    uint8_t count = 0;
+    int changed = FALSE;
+
+    /*
+        deserialise the whole frame up front, then apply the ops back to back in one
+        frame and one response, every op still does its own table lookups
+    */
+    while (cursor && *cursor) {
+        if (count >= MIPC_BATCH_MAX_OPS) {
+            printerr("too many operations in batch, ignoring the rest");
+            break;
+        }
+
+        char* next = strchr(cursor, MIPC_BATCH_DELIM);
+        if (next) {
+            *next++ = '\0';
+        }
+
+        char* op = strtrim(cursor);
+        cursor = next;
+
+        if (!*op) {
+            continue;
+        }
+
+        struct mipc_command_op_t* entry = &ops[count++];
+        entry->type = *op;
+
+        switch (entry->type) {
+        case MIPC_COMMAND_CREATE:
+        case MIPC_COMMAND_REMOVE:
+            entry->request = g_mipc_command_parse(fd, strtrim(op + 1));
+            break;
+        case MIPC_COMMAND_ROUTE:
+            entry->request = g_mipc_command_parse(fd, op);
+            break;
+        default:
+            entry->request = MIPC_EMPTY_PROCESS();
+            break;
+        }
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        struct mipc_command_op_t* entry = &ops[i];
+        int result = FALSE;
+
+        if (!mipc_process_is_empty(entry->request)) {
+            switch (entry->type) {
+            case MIPC_COMMAND_CREATE:
+                result = g_mipc_command_create(fd, entry->request);
+                break;
+            case MIPC_COMMAND_REMOVE:
+                result = g_mipc_command_remove(entry->request);
+                changed |= result;
+                break;
+            case MIPC_COMMAND_ROUTE:
+                result = g_mipc_command_route(fd, entry->request, TRUE);
+                changed |= result;
+                break;
+            }
+        }
+
+        results[i] = result ? '1' : '0';
+    }
+
+    if (changed) {
+        mipc_table_print_queue();
+    }
+
+    mipc_dispatch_write(fd, results, count);
+    return count;
+}
+
+int mipc_command_group(int fd, char* frame) {
+    char* policy = strtrim(frame);
+    char* body = strchr(policy, ' ');
+
+    if (!body) {
+        printerr("usage: g <rr|least|hash>[/msg] <serialised_structure>");
+        return FALSE;
+    }
+
+    *body++ = '\0';
+
+    int mode = MIPC_GROUP_ROUND_ROBIN;
+    int granularity = MIPC_GROUP_PER_LINK;
+    char* suffix = strchr(policy, '/');
+
+    if (suffix) {
+        if (strcmp(suffix, "/msg") != 0) {
+            printerr("unknown service group granularity");
+            return FALSE;
+        }
+
+        *suffix = '\0';
+        granularity = MIPC_GROUP_PER_MESSAGE;
+    }
+
+    /* a typo must not quietly turn into round robin */
+    if (strcmp(policy, "least") == 0) {
+        mode = MIPC_GROUP_LEAST_OUTSTANDING;
+    } else if (strcmp(policy, "hash") == 0) {
+        mode = MIPC_GROUP_AFFINITY;
+    } else if (strcmp(policy, "rr") != 0) {
+        printerr("unknown service group policy");
+        return FALSE;
+    }
+
+    struct mipc_process_request_t request = g_mipc_command_parse(fd, strtrim(body));
+    return mipc_group_join(request, fd, mode, granularity);
+}
+
+int mipc_command_stream(int fd, char* frame, size_t len) {
+    char* end = memchr(frame, '\n', len);
+
+    if (!end) {
+        g_mipc_command_drop(fd, "stream header must end with a new line, dropping client");
+        return FALSE;
+    }
+
+    *end = '\0';
+
+    const char* body = end + 1;
+    size_t body_len = len - (body - frame);
+
+    char* braces = NULL;
+    unsigned long length = 0;
+
+    if (!g_mipc_command_stream_length(frame, &length, &braces)) {
+        g_mipc_command_drop(fd, "invalid stream length, dropping client");
+        return FALSE;
+    }
+
+    /* like a vector, whatever came after the body can't be told apart from the body itself */
+    if (body_len > length) {
+        g_mipc_command_drop(fd, "stream frame goes past its body, dropping client");
+        return FALSE;
+    }
+
+    struct mipc_process_request_t request = g_mipc_command_parse(fd, strtrim(braces));
+
+    int port = request.port;
+    int pid = request.pid;
+    int server = g_mipc_command_server_fd(port, pid);
+
+    int8_t entry = mipc_table_queue_contains_both(port, pid);
+    MIPC_PROBE(TABLE_LOOKUP, fd, port, pid, entry);
+
+    if (entry == -1 || server == -1) {
+        printerr("no linked server found for stream, discarding body");
+        g_mipc_command_drain(fd, body, body_len, length);
+        return FALSE;
+    }
+
+    if (!mipc_limit_port_admit(port, length)) {
+        g_mipc_command_drain(fd, body, body_len, length);
+        mipc_limit_reject(fd, "port over its rate limit");
+        return FALSE;
+    }
+
+    /* the receiving server gets the same header with the real length in front of the body */
+    char header[MIPC_STREAM_HEADER_MAX];
+    int header_len = snprintf(
+        header, sizeof(header), "s %lu {.message=%s,.pid=%d,.port=%d}\n", length, request.message, pid, port);
+
+    MIPC_PROBE(ENQUEUE, fd, port, pid, length);
+
+    /* the sender is answered once the relay delivered the last byte */
+    if (!mipc_dispatch_stream(fd, server, header, header_len, body, body_len, length, port, pid)) {
+        g_mipc_command_drop(fd, "cannot relay stream body, dropping client");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+int mipc_command_vector(int fd, char* frame, size_t len) {
+    char* end = memchr(frame, '\n', len);
+
+    /* like a stream, the rest of a cut short vector would be read as commands */
+    if (!end) {
+        g_mipc_command_drop(fd, "vector header must end with a new line, dropping client");
+        return FALSE;
+    }
+
+    const char* body = end + 1;
+    size_t head_len = body - frame;
+    size_t body_len = len - head_len;
+
+    /* only the short header line is copied, the segments below point into the frame */
+    char header[512];
+
+    if (head_len > sizeof(header)) {
+        printerr("vector header too long");
+        return FALSE;
+    }
+
+    memcpy(header, frame, head_len - 1);
+    header[head_len - 1] = '\0';
+
+    struct iovec segments[MIPC_SEGMENT_MAX];
+    char* cursor = header + 1;
+    size_t offset = 0;
+    int count = 0;
+
+    while (TRUE) {
+        if (count >= MIPC_SEGMENT_MAX) {
+            printerr("too many segments in vector");
+            return FALSE;
+        }
+
+        unsigned long length = strtoul(cursor, &cursor, 10);
+
+        if (length > body_len - offset) {
+            g_mipc_command_drop(fd, "vector segments go past the frame, dropping client");
+            return FALSE;
+        }
+
+        segments[count].iov_base = (char*)body + offset;
+        segments[count].iov_len = length;
+
+        offset += length;
+        count++;
+
+        if (*cursor != ',') {
+            break;
+        }
+
+        cursor++;
+    }
+
+    if (offset != body_len) {
+        g_mipc_command_drop(fd, "vector frame goes past its segments, dropping client");
+        return FALSE;
+    }
+
+    struct mipc_process_request_t request = g_mipc_command_parse(fd, strtrim(cursor));
+
+    int port = request.port;
+    int pid = request.pid;
+    int server = g_mipc_command_server_fd(port, pid);
+
+    int8_t entry = mipc_table_queue_contains_both(port, pid);
+    MIPC_PROBE(TABLE_LOOKUP, fd, port, pid, entry);
+
+    if (entry == -1 || server == -1) {
+        printerr("no linked server found for vector");
+        return FALSE;
+    }
+
+    /* a frame written now would land in the middle of a stream body the server is still getting */
+    if (mipc_dispatch_busy(server)) {
+        printerr("linked server is busy with a stream");
+        return FALSE;
+    }
+
+    if (!g_mipc_command_admit(fd, port, offset, FALSE)) {
+        return FALSE;
+    }
+
+    MIPC_PROBE(ENQUEUE, fd, port, pid, offset);
+
+    if (!mipc_dispatch_send_segments(port, pid, request.message, segments, count)) {
+        return FALSE;
+    }
+
+    /* the receiving server gets the header line exactly as it was sent, followed by the segments */
+    return mipc_dispatch_deliver_segments(fd, server, port, pid, frame, head_len);
+}
+
+int mipc_command_limit(int fd, char* frame) {
+    char* spec = strtrim(frame);
+    char response[255];
+
+    /* anyone may read the limits, a client must not be able to lift its own */
+    if (*spec && !mipc_limit_authorised(fd)) {
+        mipc_limit_reject(fd, "limits can only be changed from the control socket");
+        return FALSE;
+    }
+
+    if (*spec && !mipc_limit_configure(spec)) {
+        mipc_limit_reject(fd, "invalid limits");
+        return FALSE;
+    }
+
+    memset(response, 0, 255);
+    mipc_limit_describe(response, 255);
+    println(response);
+
+    mipc_dispatch_write(fd, response, 255);
+    return TRUE;
+}
+
+int mipc_command_attach(int fd, char* frame) {
+    struct mipc_process_request_t request = g_mipc_command_parse(fd, strtrim(frame));
+    struct mipc_command_handle_t* slot = NULL;
+    char response[255];
+
+    int port = request.port;
+    int pid = request.pid;
+    int handle = -1;
+
+    /* an unlinked client is linked first, the same way its first route would */
+    if (mipc_table_queue_contains_both(port, pid) == -1) {
+        g_mipc_command_route(fd, request, TRUE);
+    }
+
+    int8_t entry = mipc_table_queue_contains_both(port, pid);
+    MIPC_PROBE(TABLE_LOOKUP, fd, port, pid, entry);
+
+    for (uint8_t i = 0; i < MIPC_COMMAND_MAX_HANDLES && entry != -1; i++) {
+        struct mipc_command_handle_t* link = &g_handles[i];
+
+        if (link->port == (uint32_t)port && link->pid == (uint32_t)pid && link->fd == fd) {
+            slot = link;
+            break;
+        }
+
+        if (!link->port && !slot) {
+            slot = link;
+        }
+    }
+
+    if (slot) {
+        slot->fd = fd;
+        slot->port = port;
+        slot->pid = pid;
+        slot->entry = entry;
+        slot->generation = mipc_table_generation();
+
+        handle = slot - g_handles;
+    } else if (entry != -1) {
+        printerr("maximum handle count reached");
+    }
+
+    memset(response, 0, 255);
+    snprintf(response, 255, "handle: %d", handle);
+    mipc_dispatch_write(fd, response, 255);
+
+    return handle != -1;
+}
+
+int mipc_command_send(int fd, char* frame, size_t len) {
+    char* payload = NULL;
+    unsigned long handle = strtoul(frame + 1, &payload, 10);
+
+    /* no digits at all must not read as handle 0 */
+    if (payload == frame + 1 || handle >= MIPC_COMMAND_MAX_HANDLES || !g_handles[handle].port || g_handles[handle].fd != fd) {
+        printerr("invalid handle for send");
+        g_mipc_command_respond(fd, "rejected: invalid handle");
+        return FALSE;
+    }
+
+    struct mipc_command_handle_t* link = &g_handles[handle];
+
+    if (*payload == ' ') {
+        payload++;
+    }
+
+    /* the tables changed since the link was cached, find it again once */
+    if (link->generation != mipc_table_generation()) {
+        link->entry = mipc_table_queue_contains_both(link->port, link->pid);
+        link->generation = mipc_table_generation();
+
+        MIPC_PROBE(TABLE_LOOKUP, fd, link->port, link->pid, link->entry);
+    }
+
+    if (link->entry == -1) {
+        printerr("mailbox link behind handle is gone");
+        g_mipc_command_respond(fd, "rejected: link is gone");
+
+        memset(link, 0, sizeof(struct mipc_command_handle_t));
+        return FALSE;
+    }
+
+    size_t payload_len = len - (payload - frame);
+
+    /* the mailbox only holds a message, a longer payload would be charged in full but cut */
+    if (payload_len > 254) {
+        printerr("payload too long for send");
+        g_mipc_command_respond(fd, "rejected: payload too long");
+        return FALSE;
+    }
+
+    if (!g_mipc_command_admit(fd, link->port, payload_len, FALSE)) {
+        return FALSE;
+    }
+
+    struct mipc_process_mailbox_t* mailbox = mipc_table_get_queue(link->entry);
+    MIPC_PROBE(ENQUEUE, fd, link->port, link->pid, payload_len);
+
+    if (!mipc_dispatch_send_mailbox(mailbox, payload)) {
+        return FALSE;
+    }
+
+    g_mipc_command_deliver_mailbox(fd, mailbox, FALSE);
+    return TRUE;
+}
+
+int mipc_command_stamp(int fd, char* frame) {
+    char* end = NULL;
+    uint64_t sent = strtoull(strtrim(frame), &end, 10);
+    uint64_t now = timenow();
+    char response[255];
+
+    /* unlike the loop's own numbers this includes the time the kernel took to wake it */
+    if (!sent || sent > now || (*end && *end != ' ')) {
+        printerr("invalid stamp");
+        return FALSE;
+    }
+
+    uint64_t latency = now - sent;
+
+    g_stamp_count++;
+    g_stamp_total += latency;
+    g_stamp_max = latency > g_stamp_max ? latency : g_stamp_max;
+
+    memset(response, 0, 255);
+    snprintf(response, 255, "stamp: %llu", (unsigned long long)latency);
+    mipc_dispatch_write(fd, response, 255);
+
+    return TRUE;
+}
+
+void mipc_command_print_stats(void) {
+    if (!g_stamp_count) {
+        return;
+    }
+
+    printf("[STAMP]: %llu stamped frames, send to dispatch avg %.2fus max %.2fus\n",
+           (unsigned long long)g_stamp_count,
+           (double)g_stamp_total / g_stamp_count / MIPC_NS_PER_USEC,
+           (double)g_stamp_max / MIPC_NS_PER_USEC);
+}
+
+int mipc_command_complete(char* frame, size_t len) {
+    if (!len || (*frame != MIPC_COMMAND_STREAM && *frame != MIPC_COMMAND_VECTOR)) {
+        return TRUE;
+    }
+
+    char* end = memchr(frame, '\n', len);
+    unsigned long length = 0;
+
+    if (!end) {
+        return FALSE;
+    }
+
+    size_t body_len = len - (end + 1 - frame);
+
+    if (*frame == MIPC_COMMAND_STREAM) {
+        return g_mipc_command_stream_length(frame, &length, NULL) && length <= body_len;
+    }
+
+    /* the segments have to fill the rest of the packet exactly */
+    char* cursor = frame + 1;
+
+    for (int count = 0; count < MIPC_SEGMENT_MAX; count++) {
+        length += strtoul(cursor, &cursor, 10);
+
+        if (length > body_len) {
+            return FALSE;
+        }
+
+        if (*cursor != ',') {
+            return length == body_len;
+        }
+
+        cursor++;
+    }
+
+    return FALSE;
+}
+
+void mipc_command_reject(int fd, char* frame, size_t len, const char* reason) {
+    mipc_limit_reject(fd, reason);
+
+    if (!len || *frame != MIPC_COMMAND_STREAM) {
+        return;
+    }
+
+    char* end = memchr(frame, '\n', len);
+    unsigned long length = 0;
+
+    if (!end || !g_mipc_command_stream_length(frame, &length, NULL)) {
+        g_mipc_command_drop(fd, "invalid stream header, dropping client");
+        return;
+    }
+
+    const char* body = end + 1;
+    g_mipc_command_drain(fd, body, len - (body - frame), length);
+}
+
+void mipc_command_disconnect(int fd) {
+    mipc_dispatch_stream_disconnect(fd);
+    mipc_group_disconnect(fd);
+    mipc_limit_close(fd);
+
+    for (uint8_t i = 0; i < MIPC_COMMAND_MAX_HANDLES; i++) {
+        if (g_handles[i].port && g_handles[i].fd == fd) {
+            memset(&g_handles[i], 0, sizeof(struct mipc_command_handle_t));
+        }
+    }
+
+    for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
+        if (g_servers[i].port && g_servers[i].fd == fd) {
+            /* a group port keeps its budget while other members still serve it */
+            if (!mipc_group_find(g_servers[i].port)) {
+                mipc_limit_port_release(g_servers[i].port);
+            }
+
+            memset(&g_servers[i], 0, sizeof(struct mipc_command_server_t));
+        }
+    }
+}
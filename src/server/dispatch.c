@@ -15,13 +15,58 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define MIPC_USE_LIBS
 #define MIPC_USE_STD
 
 #include "server/dispatch.h"
+#include "server/probes.h"
+#include "server/region.h"
 #include "server/table.h"
+#include "server/trace.h"
 
 #include "config.h"
+#include <errno.h>
 #include <string.h>
+#include <sys/event.h>
+
+/* darwin has no splice(), every relay reuses one chunk so memory stays flat for any payload size */
+static struct mipc_dispatch_relay_t g_relays[MIPC_STREAM_MAX_RELAYS];
+static size_t g_chunk_size = 0;
+static int g_kq = -1;
+
+/* indexed like the mailbox queues, only filled between a `v` frame arriving and its delivery */
+static struct mipc_dispatch_segments_t g_segments[MIPC_MAX_POLL_FDS];
+
+int mipc_dispatch_init(size_t frame) {
+    /* a chunk also has to hold the forwarded header and whatever body came with the first frame */
+    if (!g_chunk_size) {
+        g_chunk_size = frame + MIPC_STREAM_HEADER_MAX > MIPC_STREAM_CHUNK ? frame + MIPC_STREAM_HEADER_MAX
+                                                                         : MIPC_STREAM_CHUNK;
+    }
+
+    for (uint8_t i = 0; i < MIPC_STREAM_MAX_RELAYS; i++) {
+        if (!g_relays[i].chunk) {
+            g_relays[i].chunk = mipc_region_alloc(g_chunk_size);
+        }
+
+        if (!g_relays[i].chunk) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+static void g_mipc_dispatch_respond(struct mipc_process_mailbox_t* server) {
+    /* now send a nice response back to the client :) */
+    char response[255];
+
+    memset(server->second.message, 0, 255);
+    memset(response, 0, 255);
+
+    snprintf(response, 255, "response written to port: %d", server->first.port);
+    strcpy(server->second.message, response);
+}
 
 int mipc_dispatch_send_msg(int port, int pid, const char* msg) {
     if (!port && !pid) {
@@ -41,17 +86,423 @@ int mipc_dispatch_send_msg(int port, int pid, const char* msg) {
         return FALSE;
     }
 
+    return mipc_dispatch_send_mailbox(server, msg);
+}
+
+int mipc_dispatch_send_mailbox(struct mipc_process_mailbox_t* server, const char* msg) {
+    if (!server || !msg) {
+        printerr("invalid mailbox or message for dispatch");
+        return FALSE;
+    }
+
     memset(server->first.message, 0, 255);
-    strcpy(server->first.message, msg);
+    strncpy(server->first.message, msg, 254);
 
-    /* now send a nice response back to the client :) */
-    char response[255];
+    g_mipc_dispatch_respond(server);
+    return TRUE;
+}
 
-    memset(server->second.message, 0, 255);
-    memset(response, 0, 255);
+int mipc_dispatch_send_segments(int port, int pid, const char* label, const struct iovec* segments, int count) {
+    if (!port && !pid) {
+        printerr("invalid port or pid for dispatch");
+        return FALSE;
+    }
 
-    snprintf(response, 255, "response written to port: %d", server->first.port);
-    strcpy(server->second.message, response);
+    if (!segments || count <= 0 || count > MIPC_SEGMENT_MAX) {
+        printerr("invalid segments for dispatch");
+        return FALSE;
+    }
+
+    int8_t entry = mipc_table_queue_contains_both(port, pid);
+
+    if (entry == -1) {
+        printerr("no server found from mailbox for dispatch");
+        return FALSE;
+    }
+
+    struct mipc_process_mailbox_t* server = mipc_table_get_queue(entry);
+
+    memcpy(g_segments[entry].iov, segments, count * sizeof(struct iovec));
+    g_segments[entry].count = count;
 
+    /* the mailbox message only keeps the label from the header, the payload stays in the segments */
+    memset(server->first.message, 0, 255);
+    strncpy(server->first.message, label ? label : "", 254);
+
+    g_mipc_dispatch_respond(server);
     return TRUE;
 }
+
+ssize_t mipc_dispatch_write(int fd, const void* data, size_t len) {
+    ssize_t written = write(fd, data, len);
+
+    if (written > 0) {
+        MIPC_PROBE(WRITE, fd, 0, 0, written);
+        mipc_trace_record(MIPC_TRACE_SEND, fd, data, written);
+    }
+
+    return written;
+}
+
+ssize_t mipc_dispatch_writev(int fd, const struct iovec* iov, int count) {
+    struct msghdr msg;
+
+    memset(&msg, 0, sizeof(struct msghdr));
+    msg.msg_iov = (struct iovec*)iov;
+    msg.msg_iovlen = count;
+
+    /* never waits on a full receiver, whatever doesn't fit is kept by the caller */
+    ssize_t written = sendmsg(fd, &msg, MSG_DONTWAIT);
+
+    if (written > 0) {
+        MIPC_PROBE(WRITE, fd, 0, 0, written);
+        mipc_trace_record(MIPC_TRACE_SEND, fd, NULL, written);
+    }
+
+    return written;
+}
+
+static struct mipc_dispatch_relay_t* g_mipc_dispatch_find_relay(int src) {
+    for (uint8_t i = 0; i < MIPC_STREAM_MAX_RELAYS; i++) {
+        if (g_relays[i].active && g_relays[i].src == src) {
+            return &g_relays[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* the loop owns the read filter of every client, a relay only pauses and resumes it */
+static void g_mipc_dispatch_watch(int fd, int filter, int flags) {
+    struct kevent event;
+    EV_SET(&event, fd, filter, flags, 0, 0, NULL);
+
+    /* a datagram reply socket is never on the queue */
+    if (g_kq != -1 && kevent(g_kq, &event, 1, NULL, 0, NULL) == -1 && errno != ENOENT) {
+        err("could not update stream relay event");
+    }
+}
+
+static void g_mipc_dispatch_pump(struct mipc_dispatch_relay_t*, int);
+
+static void g_mipc_dispatch_release(struct mipc_dispatch_relay_t* relay) {
+    int target = relay->target;
+
+    if (relay->blocked || relay->waiting) {
+        g_mipc_dispatch_watch(relay->src, EVFILT_READ, EV_ENABLE);
+    }
+
+    char* chunk = relay->chunk;
+    memset(relay, 0, sizeof(struct mipc_dispatch_relay_t));
+    relay->chunk = chunk;
+
+    /* bodies for the same receiver go one after the other, never interleaved */
+    for (uint8_t i = 0; i < MIPC_STREAM_MAX_RELAYS && target != -1; i++) {
+        struct mipc_dispatch_relay_t* next = &g_relays[i];
+
+        if (next->active && next->waiting && next->target == target) {
+            next->waiting = FALSE;
+            g_mipc_dispatch_watch(next->src, EVFILT_READ, EV_ENABLE);
+            g_mipc_dispatch_pump(next, TRUE);
+            return;
+        }
+    }
+}
+
+static void g_mipc_dispatch_finish(struct mipc_dispatch_relay_t* relay) {
+    if (relay->respond && relay->dst != -1) {
+        char response[255];
+
+        MIPC_PROBE(DELIVER, relay->dst, relay->port, relay->pid, relay->length);
+
+        memset(response, 0, 255);
+        snprintf(response, 255, "response written to port: %d", relay->port);
+        mipc_dispatch_write(relay->src, response, 255);
+    }
+
+    g_mipc_dispatch_release(relay);
+}
+
+/* FALSE while the receiver can't take more, the relay then waits for it to become writable */
+static int g_mipc_dispatch_flush(struct mipc_dispatch_relay_t* relay) {
+    while (relay->pending) {
+        if (relay->dst == -1) {
+            relay->pending = 0;
+            break;
+        }
+
+        ssize_t written = send(relay->dst, relay->chunk + relay->offset, relay->pending, MSG_DONTWAIT);
+
+        if (written > 0) {
+            MIPC_PROBE(WRITE, relay->dst, 0, 0, written);
+            mipc_trace_record(MIPC_TRACE_SEND, relay->dst, NULL, written);
+
+            relay->offset += written;
+            relay->pending -= written;
+            continue;
+        }
+
+        if (written == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            /* the sender is paused too, or its next frames would be read before its body is done */
+            if (!relay->blocked) {
+                relay->blocked = TRUE;
+                g_mipc_dispatch_watch(relay->src, EVFILT_READ, EV_DISABLE);
+            }
+
+            g_mipc_dispatch_watch(relay->dst, EVFILT_WRITE, EV_ADD | EV_ONESHOT);
+            return FALSE;
+        }
+
+        /* keep draining the sender even if the receiver went away */
+        err("could not write stream chunk");
+        relay->dst = -1;
+    }
+
+    if (relay->blocked) {
+        relay->blocked = FALSE;
+        g_mipc_dispatch_watch(relay->src, EVFILT_READ, EV_ENABLE);
+    }
+
+    return TRUE;
+}
+
+/* moves at most one chunk per call, a slow sender or receiver never holds the loop */
+static void g_mipc_dispatch_pump(struct mipc_dispatch_relay_t* relay, int readable) {
+    if (!g_mipc_dispatch_flush(relay)) {
+        return;
+    }
+
+    if (relay->remaining && readable) {
+        size_t want = relay->remaining < MIPC_STREAM_CHUNK ? relay->remaining : MIPC_STREAM_CHUNK;
+        ssize_t got = recv(relay->src, relay->chunk, want, MSG_DONTWAIT);
+
+        if (got == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+
+        if (got <= 0) {
+            printerr("stream sender closed before the whole body arrived");
+            g_mipc_dispatch_release(relay);
+            return;
+        }
+
+        mipc_trace_record(MIPC_TRACE_RECV, relay->src, relay->chunk, got);
+
+        relay->remaining -= got;
+        relay->pending = got;
+        relay->offset = 0;
+
+        if (!g_mipc_dispatch_flush(relay)) {
+            return;
+        }
+    }
+
+    if (!relay->remaining) {
+        g_mipc_dispatch_finish(relay);
+    }
+}
+
+void mipc_dispatch_set_queue(int kq) {
+    g_kq = kq;
+}
+
+int mipc_dispatch_stream(int src,
+                         int dst,
+                         const char* head,
+                         size_t head_len,
+                         const char* body,
+                         size_t body_len,
+                         size_t length,
+                         int port,
+                         int pid) {
+    struct mipc_dispatch_relay_t* relay = NULL;
+    int busy = FALSE;
+
+    /* bytes past the body would be lost, the caller has to deal with them */
+    if (!g_chunk_size || body_len > length || head_len + body_len > g_chunk_size ||
+        g_mipc_dispatch_find_relay(src)) {
+        printerr("cannot start stream relay");
+        return FALSE;
+    }
+
+    for (uint8_t i = 0; i < MIPC_STREAM_MAX_RELAYS; i++) {
+        if (!g_relays[i].active && !relay) {
+            relay = &g_relays[i];
+        } else if (g_relays[i].active && dst != -1 && g_relays[i].target == dst) {
+            busy = TRUE;
+        }
+    }
+
+    if (!relay) {
+        printerr("maximum stream relay count reached");
+        return FALSE;
+    }
+
+    /* the forwarded header and the first body bytes that came with it go out first */
+    memcpy(relay->chunk, head, head_len);
+    memcpy(relay->chunk + head_len, body, body_len);
+
+    relay->active = TRUE;
+    relay->src = src;
+    relay->dst = dst;
+    relay->target = dst;
+    relay->port = port;
+    relay->pid = pid;
+    relay->respond = dst != -1;
+    relay->length = length;
+    relay->remaining = length - body_len;
+    relay->pending = head_len + body_len;
+    relay->offset = 0;
+
+    if (busy) {
+        relay->waiting = TRUE;
+        g_mipc_dispatch_watch(src, EVFILT_READ, EV_DISABLE);
+        return TRUE;
+    }
+
+    g_mipc_dispatch_pump(relay, TRUE);
+    return TRUE;
+}
+
+int mipc_dispatch_busy(int dst) {
+    for (uint8_t i = 0; i < MIPC_STREAM_MAX_RELAYS; i++) {
+        if (g_relays[i].active && dst != -1 && g_relays[i].target == dst) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+int mipc_dispatch_deliver_segments(int src, int dst, int port, int pid, const char* head, size_t head_len) {
+    int8_t entry = mipc_table_queue_contains_both(port, pid);
+
+    if (entry == -1 || !g_segments[entry].count) {
+        printerr("no segments found from mailbox for delivery");
+        return FALSE;
+    }
+
+    struct mipc_dispatch_segments_t* segments = &g_segments[entry];
+    struct mipc_dispatch_relay_t* relay = NULL;
+    struct iovec iov[MIPC_SEGMENT_MAX + 1];
+    int count = segments->count + 1;
+    size_t total = head_len;
+
+    iov[0].iov_base = (void*)head;
+    iov[0].iov_len = head_len;
+    memcpy(&iov[1], segments->iov, segments->count * sizeof(struct iovec));
+
+    /* the segments point into a receive buffer that the next frame reuses */
+    memset(segments, 0, sizeof(struct mipc_dispatch_segments_t));
+
+    for (int i = 1; i < count; i++) {
+        total += iov[i].iov_len;
+    }
+
+    /* a relay is taken up front, it keeps whatever the receiver can't take right now */
+    for (uint8_t i = 0; i < MIPC_STREAM_MAX_RELAYS && !relay; i++) {
+        if (!g_relays[i].active) {
+            relay = &g_relays[i];
+        }
+    }
+
+    if (!relay || total > g_chunk_size || g_mipc_dispatch_find_relay(src)) {
+        printerr("cannot keep segments for delivery");
+        return FALSE;
+    }
+
+    ssize_t written = mipc_dispatch_writev(dst, iov, count);
+
+    if (written == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        written = 0;
+    }
+
+    if (written < 0) {
+        err("could not write segments");
+        return FALSE;
+    }
+
+    relay->active = TRUE;
+    relay->src = src;
+    relay->dst = dst;
+    relay->target = dst;
+    relay->port = port;
+    relay->pid = pid;
+    relay->respond = TRUE;
+    relay->length = total - head_len;
+    relay->remaining = 0;
+    relay->pending = 0;
+    relay->offset = 0;
+
+    /* the rest is copied out of the receive buffer and sent like the tail of a stream body */
+    for (int i = 0; i < count; i++) {
+        size_t skip = (size_t)written < iov[i].iov_len ? (size_t)written : iov[i].iov_len;
+
+        memcpy(relay->chunk + relay->pending, (char*)iov[i].iov_base + skip, iov[i].iov_len - skip);
+        relay->pending += iov[i].iov_len - skip;
+        written -= skip;
+    }
+
+    g_mipc_dispatch_pump(relay, FALSE);
+    return TRUE;
+}
+
+int mipc_dispatch_stream_event(int fd, int filter) {
+    if (filter == EVFILT_WRITE) {
+        for (uint8_t i = 0; i < MIPC_STREAM_MAX_RELAYS; i++) {
+            if (g_relays[i].active && g_relays[i].blocked && g_relays[i].dst == fd) {
+                g_mipc_dispatch_pump(&g_relays[i], FALSE);
+                return TRUE;
+            }
+        }
+
+        return FALSE;
+    }
+
+    struct mipc_dispatch_relay_t* relay = g_mipc_dispatch_find_relay(fd);
+
+    if (!relay) {
+        return FALSE;
+    }
+
+    if (relay->waiting || relay->blocked) {
+        /* a deferred client's timer may have turned its reads back on */
+        g_mipc_dispatch_watch(fd, EVFILT_READ, EV_DISABLE);
+        return TRUE;
+    }
+
+    g_mipc_dispatch_pump(relay, TRUE);
+
+    return TRUE;
+}
+
+void mipc_dispatch_stream_disconnect(int fd) {
+    struct mipc_dispatch_relay_t* relay = g_mipc_dispatch_find_relay(fd);
+
+    /* the sender's events are already gone, there is nothing to turn back on */
+    if (relay) {
+        relay->blocked = FALSE;
+        relay->waiting = FALSE;
+        g_mipc_dispatch_release(relay);
+    }
+
+    /* relays into a receiver that went away keep draining their senders */
+    for (uint8_t i = 0; i < MIPC_STREAM_MAX_RELAYS; i++) {
+        relay = &g_relays[i];
+
+        if (!relay->active || relay->target != fd) {
+            continue;
+        }
+
+        relay->dst = -1;
+        relay->target = -1;
+        relay->respond = FALSE;
+
+        if (relay->blocked || relay->waiting) {
+            relay->waiting = FALSE;
+            relay->pending = 0;
+
+            g_mipc_dispatch_pump(relay, FALSE);
+        }
+    }
+}
@@ -0,0 +1,216 @@
+/**
+ * This file is part of the microipc distribution (https://github.com/MustafaMalikDev/microipc)
+ * Copyright (c) 2025 Mustafa Malik.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIPC_USE_STD
+
+#include "server/group.h"
+#include "server/registry.h"
+#include "server/table.h"
+
+#include "config.h"
+#include <string.h>
+
+static struct mipc_group_t g_groups[MIPC_MAX_POLL_FDS];
+
+/* members never go through the process table, so they are published on their own */
+static void g_mipc_group_changed(void) {
+    mipc_registry_publish_groups(g_groups, MIPC_MAX_POLL_FDS);
+}
+
+static uint32_t g_mipc_group_hash(uint32_t client, uint32_t member) {
+    uint64_t x = ((uint64_t)client << 32) | member;
+
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+
+    return (uint32_t)x;
+}
+
+struct mipc_group_t* mipc_group_find(uint32_t port) {
+    if (!port) {
+        return NULL;
+    }
+
+    for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
+        if (g_groups[i].port == port) {
+            return &g_groups[i];
+        }
+    }
+
+    return NULL;
+}
+
+struct mipc_group_member_t* mipc_group_member(struct mipc_group_t* group, uint32_t pid) {
+    for (uint8_t i = 0; group && i < group->count; i++) {
+        if (group->members[i].pid == pid) {
+            return &group->members[i];
+        }
+    }
+
+    return NULL;
+}
+
+int mipc_group_join(const struct mipc_process_request_t request, int fd, int policy, int granularity) {
+    if (!request.port || !request.pid) {
+        printerr("invalid port or pid for service group");
+        return FALSE;
+    }
+
+    /* a port is either a single process in the table or a group, never both */
+    if (mipc_table_contains(request) != -1) {
+        printerr("cannot join a group on a port or pid already in the process table");
+        return FALSE;
+    }
+
+    struct mipc_group_t* group = mipc_group_find(request.port);
+
+    if (!group) {
+        for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS && !group; i++) {
+            if (!g_groups[i].port) {
+                group = &g_groups[i];
+            }
+        }
+
+        if (!group) {
+            printerr("maximum service group count reached");
+            return FALSE;
+        }
+
+        memset(group, 0, sizeof(struct mipc_group_t));
+        group->port = request.port;
+        group->policy = policy;
+        group->granularity = granularity;
+    } else if (group->policy != policy || group->granularity != granularity) {
+        printerr("service group members must all use the policy the group was created with");
+        return FALSE;
+    }
+
+    if (mipc_group_member(group, request.pid)) {
+        printerr("cannot insert same process in entry");
+        return FALSE;
+    }
+
+    if (group->count >= MIPC_MAX_POLL_FDS) {
+        printerr("maximum service group size reached");
+        return FALSE;
+    }
+
+    struct mipc_group_member_t* member = &group->members[group->count++];
+    member->pid = request.pid;
+    member->fd = fd;
+    member->routed = 0;
+
+    g_mipc_group_changed();
+    return TRUE;
+}
+
+struct mipc_group_member_t* mipc_group_pick(struct mipc_group_t* group, uint32_t client) {
+    struct mipc_group_member_t* best = NULL;
+
+    if (!group || !group->count) {
+        return NULL;
+    }
+
+    if (group->policy == MIPC_GROUP_ROUND_ROBIN) {
+        return &group->members[group->next++ % group->count];
+    }
+
+    uint32_t best_score = 0;
+    uint8_t best_links = UINT8_MAX;
+
+    for (uint8_t i = 0; i < group->count; i++) {
+        struct mipc_group_member_t* member = &group->members[i];
+
+        if (group->policy == MIPC_GROUP_AFFINITY) {
+            /* highest random weight: removing a member only moves the clients it owned */
+            uint32_t score = g_mipc_group_hash(client, member->pid);
+
+            if (!best || score > best_score) {
+                best = member;
+                best_score = score;
+            }
+        } else {
+            uint8_t links = mipc_table_queue_count(group->port, member->pid);
+
+            if (!best || links < best_links || (links == best_links && member->routed < best->routed)) {
+                best = member;
+                best_links = links;
+            }
+        }
+    }
+
+    return best;
+}
+
+int mipc_group_leave(uint32_t port, uint32_t pid) {
+    struct mipc_group_t* group = mipc_group_find(port);
+    struct mipc_group_member_t* member = mipc_group_member(group, pid);
+
+    if (!member) {
+        return FALSE;
+    }
+
+    uint8_t index = member - group->members;
+    memmove(member, member + 1, (group->count - index - 1) * sizeof(struct mipc_group_member_t));
+    group->count--;
+
+    /* move the links of the member that left instead of dropping them */
+    for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
+        struct mipc_process_mailbox_t* queue = mipc_table_get_queue(i);
+
+        if (queue->first.port != port || queue->first.pid != pid) {
+            continue;
+        }
+
+        struct mipc_group_member_t* next = mipc_group_pick(group, queue->second.pid);
+
+        if (next) {
+            struct mipc_process_request_t server = queue->first;
+            server.pid = next->pid;
+
+            mipc_table_rebind_queue(i, server);
+        }
+    }
+
+    if (!group->count) {
+        struct mipc_process_request_t target = MIPC_EMPTY_PROCESS();
+        target.port = port;
+
+        mipc_table_destroy_queue(target);
+        memset(group, 0, sizeof(struct mipc_group_t));
+    }
+
+    g_mipc_group_changed();
+    return TRUE;
+}
+
+void mipc_group_disconnect(int fd) {
+    for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
+        struct mipc_group_t* group = &g_groups[i];
+
+        for (uint8_t j = group->count; j > 0; j--) {
+            struct mipc_group_member_t* member = &group->members[j - 1];
+
+            if (member->fd == fd) {
+                mipc_group_leave(group->port, member->pid);
+            }
+        }
+    }
+}
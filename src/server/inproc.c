@@ -0,0 +1,242 @@
+/**
+ * This file is part of the microipc distribution (https://github.com/MustafaMalikDev/microipc)
+ * Copyright (c) 2025 Mustafa Malik.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIPC_USE_STD
+
+#include "server/inproc.h"
+
+#include "config.h"
+#include <pthread.h>
+#include <string.h>
+
+/*
+    register/link/remove are rare so they are serialised by a lock,
+    send/recv/reply never take it and only touch the lock-free queues
+*/
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct mipc_inproc_endpoint_t g_endpoints[MIPC_MAX_POLL_FDS];
+static struct mipc_inproc_link_t g_links[MIPC_MAX_POLL_FDS];
+
+static struct mipc_inproc_endpoint_t* g_mipc_inproc_find_endpoint(uint32_t port) {
+    if (!port) {
+        return NULL;
+    }
+
+    for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
+        if (__atomic_load_n(&g_endpoints[i].port, __ATOMIC_ACQUIRE) == port) {
+            return &g_endpoints[i];
+        }
+    }
+
+    return NULL;
+}
+
+static struct mipc_inproc_link_t* g_mipc_inproc_find_link(uint32_t port, uint32_t pid) {
+    if (!port || !pid) {
+        return NULL;
+    }
+
+    for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
+        struct mipc_inproc_link_t* link = &g_links[i];
+
+        if (__atomic_load_n(&link->port, __ATOMIC_ACQUIRE) == port && link->pid == pid) {
+            return link;
+        }
+    }
+
+    return NULL;
+}
+
+static void g_mipc_inproc_to_msg(struct mipc_queue_msg_t* msg, uint32_t port, uint32_t pid, const char* message) {
+    memset(msg->message, 0, sizeof(msg->message));
+    strncpy(msg->message, message, sizeof(msg->message) - 1);
+
+    msg->port = port;
+    msg->pid = pid;
+}
+
+static void g_mipc_inproc_to_request(struct mipc_process_request_t* request, const struct mipc_queue_msg_t* msg) {
+    *request = MIPC_EMPTY_PROCESS();
+    memcpy(request->message, msg->message, sizeof(request->message));
+
+    request->port = msg->port;
+    request->pid = msg->pid;
+}
+
+int mipc_inproc_register(const struct mipc_process_request_t request) {
+    if (mipc_process_is_empty(request) || !request.port) {
+        printerr("invalid process for in-process register");
+        return FALSE;
+    }
+
+    struct mipc_inproc_endpoint_t* slot = NULL;
+
+    pthread_mutex_lock(&g_lock);
+
+    for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
+        struct mipc_inproc_endpoint_t* entry = &g_endpoints[i];
+
+        if (entry->port == request.port || (entry->port && request.pid && entry->pid == request.pid)) {
+            pthread_mutex_unlock(&g_lock);
+            printerr("cannot insert same process in entry");
+            return FALSE;
+        }
+
+        if (!entry->port && !slot) {
+            slot = entry;
+        }
+    }
+
+    if (!slot) {
+        pthread_mutex_unlock(&g_lock);
+        printerr("maximum process table count reached");
+        return FALSE;
+    }
+
+    mipc_queue_mpsc_init(&slot->inbox);
+    slot->pid = request.pid;
+
+    /* publishing the port last makes the endpoint visible to senders */
+    __atomic_store_n(&slot->port, request.port, __ATOMIC_RELEASE);
+
+    pthread_mutex_unlock(&g_lock);
+    return TRUE;
+}
+
+int mipc_inproc_link(const struct mipc_process_request_t request) {
+    if (!request.port || !request.pid) {
+        printerr("invalid port or pid for in-process link");
+        return FALSE;
+    }
+
+    struct mipc_inproc_link_t* slot = NULL;
+
+    pthread_mutex_lock(&g_lock);
+
+    if (!g_mipc_inproc_find_endpoint(request.port) || g_mipc_inproc_find_link(request.port, request.pid)) {
+        pthread_mutex_unlock(&g_lock);
+        printerr("cannot link, port is not registered or already linked");
+        return FALSE;
+    }
+
+    for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
+        if (!g_links[i].port) {
+            slot = &g_links[i];
+            break;
+        }
+    }
+
+    if (!slot) {
+        pthread_mutex_unlock(&g_lock);
+        printerr("maximum mailbox queue count reached");
+        return FALSE;
+    }
+
+    mipc_queue_spsc_init(&slot->reply);
+    slot->pid = request.pid;
+    __atomic_store_n(&slot->port, request.port, __ATOMIC_RELEASE);
+
+    pthread_mutex_unlock(&g_lock);
+    return TRUE;
+}
+
+int mipc_inproc_send(const struct mipc_process_request_t request) {
+    struct mipc_inproc_endpoint_t* server = g_mipc_inproc_find_endpoint(request.port);
+
+    if (!server || !g_mipc_inproc_find_link(request.port, request.pid)) {
+        printerr("no server found from mailbox for dispatch");
+        return FALSE;
+    }
+
+    struct mipc_queue_msg_t msg;
+    g_mipc_inproc_to_msg(&msg, request.port, request.pid, request.message);
+
+    return mipc_queue_mpsc_push(&server->inbox, &msg);
+}
+
+int mipc_inproc_recv(uint32_t port, struct mipc_process_request_t* request, uint32_t timeout) {
+    struct mipc_inproc_endpoint_t* server = g_mipc_inproc_find_endpoint(port);
+    struct mipc_queue_msg_t msg;
+
+    if (!server || !request) {
+        return FALSE;
+    }
+
+    if (!mipc_queue_mpsc_pop_wait(&server->inbox, &msg, timeout)) {
+        return FALSE;
+    }
+
+    g_mipc_inproc_to_request(request, &msg);
+    return TRUE;
+}
+
+int mipc_inproc_reply(uint32_t port, uint32_t pid, const char* message) {
+    struct mipc_inproc_link_t* link = g_mipc_inproc_find_link(port, pid);
+
+    if (!link || !message) {
+        return FALSE;
+    }
+
+    struct mipc_queue_msg_t msg;
+    g_mipc_inproc_to_msg(&msg, port, pid, message);
+
+    return mipc_queue_spsc_push(&link->reply, &msg);
+}
+
+int mipc_inproc_recv_reply(uint32_t port, uint32_t pid, struct mipc_process_request_t* response, uint32_t timeout) {
+    struct mipc_inproc_link_t* link = g_mipc_inproc_find_link(port, pid);
+    struct mipc_queue_msg_t msg;
+
+    if (!link || !response) {
+        return FALSE;
+    }
+
+    if (!mipc_queue_spsc_pop_wait(&link->reply, &msg, timeout)) {
+        return FALSE;
+    }
+
+    g_mipc_inproc_to_request(response, &msg);
+    return TRUE;
+}
+
+/*
+    same rules as mipc_table_remove + mipc_table_destroy_queue, callers must
+    stop their send/recv threads for an endpoint before removing it
+*/
+void mipc_inproc_remove(const struct mipc_process_request_t request) {
+    pthread_mutex_lock(&g_lock);
+
+    for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
+        struct mipc_inproc_endpoint_t* entry = &g_endpoints[i];
+
+        if (entry->port && (entry->port == request.port || (request.pid && entry->pid == request.pid))) {
+            __atomic_store_n(&entry->port, 0, __ATOMIC_RELEASE);
+            entry->pid = 0;
+        }
+    }
+
+    for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
+        struct mipc_inproc_link_t* link = &g_links[i];
+
+        if (link->port && (link->port == request.port || (request.pid && link->pid == request.pid))) {
+            __atomic_store_n(&link->port, 0, __ATOMIC_RELEASE);
+            link->pid = 0;
+        }
+    }
+
+    pthread_mutex_unlock(&g_lock);
+}
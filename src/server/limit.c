@@ -0,0 +1,349 @@
+/**
+ * This file is part of the microipc distribution (https://github.com/MustafaMalikDev/microipc)
+ * Copyright (c) 2025 Mustafa Malik.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIPC_USE_STD
+
+#include "server/limit.h"
+#include "server/probes.h"
+
+#include "config.h"
+#include "timeutil.h"
+
+#include <string.h>
+
+static struct mipc_limit_config_t g_config = {0, 0, 0, 0, 0, MIPC_LIMIT_REJECT};
+static struct mipc_limit_conn_t g_conns[MIPC_LIMIT_MAX_CONNS];
+static struct mipc_limit_port_t g_ports[MIPC_LIMIT_MAX_PORTS];
+static uint32_t g_open = 0;
+static uint64_t g_rejected = 0;
+
+static void g_mipc_limit_fill(struct mipc_limit_bucket_t* bucket, uint32_t rate, uint64_t now) {
+    bucket->tokens = rate;
+    bucket->last = now;
+}
+
+static void g_mipc_limit_refill(struct mipc_limit_bucket_t* bucket, uint32_t rate, uint64_t now) {
+    bucket->tokens += (double)(now - bucket->last) * rate / MIPC_NS_PER_SEC;
+    bucket->last = now;
+
+    if (bucket->tokens > rate) {
+        bucket->tokens = rate;
+    }
+}
+
+/*
+    a cost bigger than the whole burst is let through once the bucket is full
+    and leaves it in debt, otherwise one large frame could never pass
+*/
+static uint64_t g_mipc_limit_wait(struct mipc_limit_bucket_t* bucket, uint32_t rate, double cost, uint64_t now) {
+    if (!rate) {
+        return 0;
+    }
+
+    g_mipc_limit_refill(bucket, rate, now);
+
+    double need = cost < rate ? cost : rate;
+
+    if (bucket->tokens >= need) {
+        return 0;
+    }
+
+    return (uint64_t)((need - bucket->tokens) * MIPC_NS_PER_SEC / rate) + 1;
+}
+
+static struct mipc_limit_conn_t* g_mipc_limit_find_conn(int fd) {
+    for (uint8_t i = 0; i < MIPC_LIMIT_MAX_CONNS; i++) {
+        if (g_conns[i].used && g_conns[i].fd == fd) {
+            return &g_conns[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* control connections are never counted, the cap must not lock the operator out */
+static struct mipc_limit_conn_t* g_mipc_limit_add_conn(int fd, int control) {
+    if (!control && g_config.conns && g_open >= g_config.conns) {
+        return NULL;
+    }
+
+    uint64_t now = timenow();
+
+    for (uint8_t i = 0; i < MIPC_LIMIT_MAX_CONNS; i++) {
+        struct mipc_limit_conn_t* conn = &g_conns[i];
+
+        if (!conn->used) {
+            conn->used = TRUE;
+            conn->fd = fd;
+            conn->control = control;
+
+            g_mipc_limit_fill(&conn->msgs, g_config.conn_msgs, now);
+            g_mipc_limit_fill(&conn->bytes, g_config.conn_bytes, now);
+
+            g_open += !control;
+            return conn;
+        }
+    }
+
+    return NULL;
+}
+
+static struct mipc_limit_port_t* g_mipc_limit_find_port(uint32_t port) {
+    struct mipc_limit_port_t* slot = NULL;
+
+    for (uint8_t i = 0; i < MIPC_LIMIT_MAX_PORTS; i++) {
+        if (g_ports[i].port == port) {
+            return &g_ports[i];
+        }
+
+        if (!g_ports[i].port && !slot) {
+            slot = &g_ports[i];
+        }
+    }
+
+    if (slot) {
+        uint64_t now = timenow();
+
+        slot->port = port;
+        g_mipc_limit_fill(&slot->msgs, g_config.port_msgs, now);
+        g_mipc_limit_fill(&slot->bytes, g_config.port_bytes, now);
+    }
+
+    return slot;
+}
+
+/* only plain digits that fit, an empty or mistyped value must not quietly turn into unlimited */
+static int g_mipc_limit_number(const char* value, uint32_t* number) {
+    uint64_t total = 0;
+
+    if (!*value) {
+        return FALSE;
+    }
+
+    for (const char* c = value; *c; c++) {
+        if (*c < '0' || *c > '9') {
+            return FALSE;
+        }
+
+        total = total * 10 + (*c - '0');
+
+        if (total > UINT32_MAX) {
+            return FALSE;
+        }
+    }
+
+    *number = (uint32_t)total;
+    return TRUE;
+}
+
+int mipc_limit_configure(const char* spec) {
+    if (!spec) {
+        return FALSE;
+    }
+
+    struct mipc_limit_config_t config = g_config;
+    char copy[255];
+    char* save = NULL;
+
+    memset(copy, 0, sizeof(copy));
+    strncpy(copy, spec, sizeof(copy) - 1);
+
+    for (char* pair = strtok_r(copy, ", ", &save); pair; pair = strtok_r(NULL, ", ", &save)) {
+        char* value = strchr(pair, '=');
+
+        if (!value) {
+            printerr("limits are given as key=value");
+            return FALSE;
+        }
+
+        *value++ = '\0';
+        uint32_t number = 0;
+
+        if (strcmp(pair, "mode") == 0) {
+            if (strcmp(value, "defer") == 0) {
+                config.mode = MIPC_LIMIT_DEFER;
+            } else if (strcmp(value, "reject") == 0) {
+                config.mode = MIPC_LIMIT_REJECT;
+            } else {
+                printerr("limit mode is either defer or reject");
+                return FALSE;
+            }
+
+            continue;
+        }
+
+        if (!g_mipc_limit_number(value, &number)) {
+            printerr("limits are given as whole numbers");
+            return FALSE;
+        }
+
+        if (strcmp(pair, "conn_msgs") == 0) {
+            config.conn_msgs = number;
+        } else if (strcmp(pair, "conn_bytes") == 0) {
+            config.conn_bytes = number;
+        } else if (strcmp(pair, "port_msgs") == 0) {
+            config.port_msgs = number;
+        } else if (strcmp(pair, "port_bytes") == 0) {
+            config.port_bytes = number;
+        } else if (strcmp(pair, "conns") == 0) {
+            config.conns = number;
+        } else {
+            printerr("unknown limit");
+            return FALSE;
+        }
+    }
+
+    g_config = config;
+
+    /* new rates start from a full bucket, the connection cap only applies to new connections */
+    uint64_t now = timenow();
+
+    for (uint8_t i = 0; i < MIPC_LIMIT_MAX_CONNS; i++) {
+        g_mipc_limit_fill(&g_conns[i].msgs, g_config.conn_msgs, now);
+        g_mipc_limit_fill(&g_conns[i].bytes, g_config.conn_bytes, now);
+    }
+
+    for (uint8_t i = 0; i < MIPC_LIMIT_MAX_PORTS; i++) {
+        g_mipc_limit_fill(&g_ports[i].msgs, g_config.port_msgs, now);
+        g_mipc_limit_fill(&g_ports[i].bytes, g_config.port_bytes, now);
+    }
+
+    return TRUE;
+}
+
+int mipc_limit_describe(char* buffer, size_t size) {
+    return snprintf(buffer,
+                    size,
+                    "conn_msgs=%u,conn_bytes=%u,port_msgs=%u,port_bytes=%u,conns=%u,mode=%s",
+                    g_config.conn_msgs,
+                    g_config.conn_bytes,
+                    g_config.port_msgs,
+                    g_config.port_bytes,
+                    g_config.conns,
+                    g_config.mode == MIPC_LIMIT_DEFER ? "defer" : "reject");
+}
+
+int mipc_limit_mode(void) {
+    return g_config.mode;
+}
+
+/* with no cap a connection that does not fit in the table simply goes unlimited */
+int mipc_limit_open(int fd) {
+    return g_mipc_limit_find_conn(fd) || g_mipc_limit_add_conn(fd, FALSE) || !g_config.conns;
+}
+
+void mipc_limit_close(int fd) {
+    struct mipc_limit_conn_t* conn = g_mipc_limit_find_conn(fd);
+
+    if (conn) {
+        g_open -= !conn->control;
+        memset(conn, 0, sizeof(struct mipc_limit_conn_t));
+    }
+}
+
+void mipc_limit_authorise(int fd) {
+    struct mipc_limit_conn_t* conn = g_mipc_limit_find_conn(fd);
+
+    if (conn && !conn->control) {
+        g_open--;
+        conn->control = TRUE;
+    } else if (!conn) {
+        g_mipc_limit_add_conn(fd, TRUE);
+    }
+}
+
+int mipc_limit_authorised(int fd) {
+    struct mipc_limit_conn_t* conn = g_mipc_limit_find_conn(fd);
+    return conn && conn->control;
+}
+
+uint64_t mipc_limit_conn_admit(int fd, size_t bytes) {
+    struct mipc_limit_conn_t* conn = g_mipc_limit_find_conn(fd);
+
+    /* datagram peers are never accepted, they are counted from their first frame */
+    if (!conn && !(conn = g_mipc_limit_add_conn(fd, FALSE))) {
+        return g_config.conns ? UINT64_MAX : 0;
+    }
+
+    uint64_t now = timenow();
+    uint64_t msgs = g_mipc_limit_wait(&conn->msgs, g_config.conn_msgs, 1, now);
+    uint64_t data = g_mipc_limit_wait(&conn->bytes, g_config.conn_bytes, bytes, now);
+
+    if (msgs || data) {
+        return msgs > data ? msgs : data;
+    }
+
+    conn->msgs.tokens -= 1;
+    conn->bytes.tokens -= bytes;
+    return 0;
+}
+
+int mipc_limit_port_admit(uint32_t port, size_t bytes) {
+    if (!g_config.port_msgs && !g_config.port_bytes) {
+        return TRUE;
+    }
+
+    struct mipc_limit_port_t* entry = g_mipc_limit_find_port(port);
+
+    /* a port that can't be tracked is refused, letting it through would leave it unlimited */
+    if (!entry) {
+        printerr("maximum limited port count reached");
+        return FALSE;
+    }
+
+    uint64_t now = timenow();
+
+    if (g_mipc_limit_wait(&entry->msgs, g_config.port_msgs, 1, now) ||
+        g_mipc_limit_wait(&entry->bytes, g_config.port_bytes, bytes, now)) {
+        return FALSE;
+    }
+
+    entry->msgs.tokens -= 1;
+    entry->bytes.tokens -= bytes;
+    return TRUE;
+}
+
+void mipc_limit_port_release(uint32_t port) {
+    for (uint8_t i = 0; i < MIPC_LIMIT_MAX_PORTS; i++) {
+        if (port && g_ports[i].port == port) {
+            memset(&g_ports[i], 0, sizeof(struct mipc_limit_port_t));
+        }
+    }
+}
+
+void mipc_limit_reject(int fd, const char* reason) {
+    char response[255];
+
+    memset(response, 0, 255);
+    snprintf(response, 255, "rejected: %s", reason);
+
+    /*
+        not traced, whether a frame is rejected depends on the limits the server
+        runs with and a replay must not wait for an answer it may never get
+    */
+    g_rejected++;
+
+    if (write(fd, response, 255) > 0) {
+        MIPC_PROBE(WRITE, fd, 0, 0, 255);
+    }
+}
+
+void mipc_limit_print_stats(void) {
+    if (g_rejected) {
+        printf("[LIMIT]: %llu frames rejected\n", (unsigned long long)g_rejected);
+    }
+}
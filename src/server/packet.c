@@ -0,0 +1,340 @@
+/**
+ * This file is part of the microipc distribution (https://github.com/MustafaMalikDev/microipc)
+ * Copyright (c) 2025 Mustafa Malik.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIPC_USE_LIBS
+#define MIPC_USE_STD
+
+#include "server/packet.h"
+#include "server/region.h"
+
+#include "config.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+
+/* darwin has neither SOCK_SEQPACKET on AF_UNIX nor recvmmsg, linux and the BSDs have both */
+#ifdef MSG_WAITFORONE
+#define MIPC_HAVE_RECVMMSG
+#endif
+
+/* a datagram sender, responses go out on a socket connected to the address it bound */
+struct mipc_packet_peer_t {
+    char path[MIPC_SUN_SOCK_LEN + 1];
+    int fd;
+};
+
+struct mipc_packet_frame_t {
+    struct sockaddr_un from;
+    socklen_t from_len;
+    ssize_t len;
+    int truncated;
+};
+
+static const char* g_name = NULL;
+static int g_listener = -1;
+static int g_type = SOCK_SEQPACKET;
+static int g_frame_size = 0;
+static char* g_frames = NULL;
+
+static struct mipc_packet_peer_t g_peers[MIPC_MAX_POLL_FDS];
+static int g_conns[MIPC_PACKET_MAX_CONNS];
+static uint8_t g_conn_count = 0;
+
+static char* g_mipc_packet_frame(int index) {
+    return g_frames + (size_t)index * g_frame_size;
+}
+
+static void g_mipc_packet_prepare(struct msghdr* msg, struct iovec* iov, struct mipc_packet_frame_t* frame, int index) {
+    memset(msg, 0, sizeof(struct msghdr));
+
+    iov->iov_base = g_mipc_packet_frame(index);
+    iov->iov_len = g_frame_size - 1;
+
+    msg->msg_iov = iov;
+    msg->msg_iovlen = 1;
+    msg->msg_name = &frame->from;
+    msg->msg_namelen = sizeof(frame->from);
+}
+
+static void g_mipc_packet_finish(const struct msghdr* msg, struct mipc_packet_frame_t* frame, ssize_t len) {
+    frame->from_len = msg->msg_namelen;
+    frame->len = len;
+    frame->truncated = msg->msg_flags & MSG_TRUNC;
+}
+
+#ifdef MIPC_HAVE_RECVMMSG
+/* one syscall for the whole batch */
+static int g_mipc_packet_drain(int fd, struct mipc_packet_frame_t* frames) {
+    struct mmsghdr msgs[MIPC_PACKET_BATCH];
+    struct iovec iov[MIPC_PACKET_BATCH];
+
+    for (int i = 0; i < MIPC_PACKET_BATCH; i++) {
+        g_mipc_packet_prepare(&msgs[i].msg_hdr, &iov[i], &frames[i], i);
+        msgs[i].msg_len = 0;
+    }
+
+    int count = recvmmsg(fd, msgs, MIPC_PACKET_BATCH, MSG_DONTWAIT, NULL);
+
+    for (int i = 0; i < count; i++) {
+        g_mipc_packet_finish(&msgs[i].msg_hdr, &frames[i], msgs[i].msg_len);
+    }
+
+    return count;
+}
+#else
+/* one recvmsg per message, but all of them in one wakeup until the socket runs dry */
+static int g_mipc_packet_drain(int fd, struct mipc_packet_frame_t* frames) {
+    struct msghdr msg;
+    struct iovec iov;
+    int count = 0;
+
+    while (count < MIPC_PACKET_BATCH) {
+        g_mipc_packet_prepare(&msg, &iov, &frames[count], count);
+
+        ssize_t len = recvmsg(fd, &msg, MSG_DONTWAIT);
+        if (len == -1) {
+            return count ? count : -1;
+        }
+
+        g_mipc_packet_finish(&msg, &frames[count], len);
+        count++;
+
+        if (!len) {
+            break;
+        }
+    }
+
+    return count;
+}
+#endif
+
+static void g_mipc_packet_forget(struct mipc_packet_peer_t* peer, mipc_packet_handler_fn handler) {
+    handler(peer->fd, NULL, 0);
+    close(peer->fd);
+
+    memset(peer, 0, sizeof(struct mipc_packet_peer_t));
+}
+
+/* datagram peers never disconnect, a peer whose socket file is gone is treated as closed */
+static struct mipc_packet_peer_t* g_mipc_packet_reap(mipc_packet_handler_fn handler) {
+    struct mipc_packet_peer_t* slot = NULL;
+
+    for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
+        if (g_peers[i].path[0] && access(g_peers[i].path, F_OK) == -1) {
+            g_mipc_packet_forget(&g_peers[i], handler);
+            slot = slot ? slot : &g_peers[i];
+        }
+    }
+
+    return slot;
+}
+
+static int g_mipc_packet_peer(const struct mipc_packet_frame_t* frame, mipc_packet_handler_fn handler) {
+    const char* path = frame->from.sun_path;
+    struct mipc_packet_peer_t* slot = NULL;
+
+    if (frame->from_len <= offsetof(struct sockaddr_un, sun_path) || !*path) {
+        printerr("packet clients must bind a reply address");
+        return -1;
+    }
+
+    for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
+        if (g_peers[i].path[0] && strncmp(g_peers[i].path, path, MIPC_SUN_SOCK_LEN) == 0) {
+            return g_peers[i].fd;
+        }
+
+        if (!g_peers[i].path[0] && !slot) {
+            slot = &g_peers[i];
+        }
+    }
+
+    slot = slot ? slot : g_mipc_packet_reap(handler);
+
+    if (!slot) {
+        printerr("maximum packet peer count reached");
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+
+    if (fd == -1 || connect(fd, (const struct sockaddr*)&frame->from, frame->from_len) == -1) {
+        err("could not connect to packet client");
+
+        if (fd != -1) {
+            close(fd);
+        }
+
+        return -1;
+    }
+
+    strncpy(slot->path, path, MIPC_SUN_SOCK_LEN);
+    slot->fd = fd;
+
+    return fd;
+}
+
+int mipc_packet_listen(const char* name, int size) {
+    if (!name || size <= 1 || g_listener != -1) {
+        return -1;
+    }
+
+    if (strlen(name) > MIPC_SUN_SOCK_LEN) {
+        printerr("name too long");
+        return -1;
+    }
+
+    g_frames = mipc_region_alloc(MIPC_PACKET_BATCH * (size_t)size);
+    if (!g_frames) {
+        printerr("could not allocate packet buffers");
+        return -1;
+    }
+
+    g_frame_size = size;
+    g_type = SOCK_SEQPACKET;
+    g_listener = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+
+    if (g_listener == -1) {
+        /* datagrams keep the boundaries too, there is just no connection to accept */
+        g_type = SOCK_DGRAM;
+        g_listener = socket(AF_UNIX, SOCK_DGRAM, 0);
+    }
+
+    if (g_listener == -1) {
+        err("could not create packet socket");
+        return -1;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(struct sockaddr_un));
+
+    addr.sun_len = MIPC_SUN_SOCK_LEN + 1;
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, name, MIPC_SUN_SOCK_LEN);
+
+    unlink(name);
+    g_name = name;
+
+    if (bind(g_listener, (const struct sockaddr*)&addr, sizeof(struct sockaddr_un)) == -1) {
+        err("could not bind the packet socket");
+        mipc_packet_close();
+        return -1;
+    }
+
+    if (g_type == SOCK_SEQPACKET && listen(g_listener, MIPC_MAX_POLL_FDS) == -1) {
+        err("could not listen on the packet socket");
+        mipc_packet_close();
+        return -1;
+    }
+
+    return g_listener;
+}
+
+int mipc_packet_connected(void) {
+    return g_type == SOCK_SEQPACKET;
+}
+
+int mipc_packet_adopt(int fd) {
+    if (g_conn_count >= MIPC_PACKET_MAX_CONNS) {
+        printerr("maximum packet connection count reached");
+        return FALSE;
+    }
+
+    g_conns[g_conn_count++] = fd;
+    return TRUE;
+}
+
+int mipc_packet_owns(int fd) {
+    for (uint8_t i = 0; i < g_conn_count; i++) {
+        if (g_conns[i] == fd) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+void mipc_packet_release(int fd) {
+    for (uint8_t i = 0; i < g_conn_count; i++) {
+        if (g_conns[i] == fd) {
+            g_conns[i] = g_conns[--g_conn_count];
+            return;
+        }
+    }
+}
+
+int mipc_packet_recv(int fd, mipc_packet_handler_fn handler) {
+    struct mipc_packet_frame_t frames[MIPC_PACKET_BATCH];
+    int count = g_mipc_packet_drain(fd, frames);
+
+    if (count == -1) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            err("could not read packet socket");
+        }
+
+        return 0;
+    }
+
+    for (int i = 0; i < count; i++) {
+        char* frame = g_mipc_packet_frame(i);
+        ssize_t len = frames[i].len;
+
+        /* an empty read on a connection is its end, the kernel queue reports that separately */
+        if (len <= 0) {
+            continue;
+        }
+
+        if (frames[i].truncated) {
+            printerr("packet larger than the connection buffer, dropped");
+            memset(frame, 0, g_frame_size);
+            continue;
+        }
+
+        int client = g_type == SOCK_DGRAM ? g_mipc_packet_peer(&frames[i], handler) : fd;
+
+        if (client != -1) {
+            frame[len] = '\0';
+            handler(client, frame, len);
+        }
+
+        memset(frame, 0, len + 1);
+    }
+
+    return count;
+}
+
+void mipc_packet_close(void) {
+    if (g_listener == -1) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
+        if (g_peers[i].path[0]) {
+            close(g_peers[i].fd);
+            memset(&g_peers[i], 0, sizeof(struct mipc_packet_peer_t));
+        }
+    }
+
+    close(g_listener);
+    unlink(g_name);
+    g_listener = -1;
+    g_conn_count = 0;
+
+    mipc_region_free(g_frames);
+
+    g_frames = NULL;
+}
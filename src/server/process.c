@@ -15,12 +15,14 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define MIPC_USE_LIBS
 #define MIPC_USE_STD
 
 #include "server/process.h"
 
 #include "config.h"
 #include "strutil.h"
+#include "timeutil.h"
 
 static size_t g_mipc_process_extract(char dest[], char str[], char delim, size_t start) {
     size_t len = strlen(str);
@@ -29,7 +31,11 @@ static size_t g_mipc_process_extract(char dest[], char str[], char delim, size_t
 
     memset(dest, 0, len);
 
-    while (str[index] != delim) {
+    if (start >= len) {
+        return len;
+    }
+
+    while (str[index] && str[index] != delim) {
         if (dest_index >= len) {
             break;
         }
@@ -60,15 +66,20 @@ struct mipc_process_request_t mipc_process_deserialise(const char* request) {
     struct mipc_process_request_t data = MIPC_EMPTY_PROCESS();
     size_t len = strlen(request);
 
-    char req_copy[len];
-    char buffer[len];
+    if (!len) {
+        printerr("invalid brace syntax");
+        return MIPC_EMPTY_PROCESS();
+    }
+
+    char req_copy[len + 1];
+    char buffer[len + 1];
     char message[255];
 
     uint32_t pid = 0;
     uint32_t port = 0;
 
-    memset(req_copy, 0, len);
-    memset(buffer, 0, len);
+    memset(req_copy, 0, len + 1);
+    memset(buffer, 0, len + 1);
     memset(message, 0, 255);
     strcpy(req_copy, request);
 
@@ -81,7 +92,15 @@ struct mipc_process_request_t mipc_process_deserialise(const char* request) {
     }
 
     size_t next_index = g_mipc_process_extract(buffer, req_copy, ',', 2);
-    strcpy(message, strremove(buffer, "message="));
+    const char* field = strremove(buffer, "message=");
+
+    /* frames are bigger than a message, one that doesn't fit must not be cut or overflow */
+    if (strlen(field) > sizeof(message) - 1) {
+        printerr("message longer than 254 bytes");
+        return MIPC_EMPTY_PROCESS();
+    }
+
+    strncpy(message, field, sizeof(message) - 1);
 
     next_index = g_mipc_process_extract(buffer, req_copy, ',', next_index + 2);
     strremove(buffer, "pid=");
@@ -92,10 +111,67 @@ struct mipc_process_request_t mipc_process_deserialise(const char* request) {
     port = atoi(buffer);
 
     memset(data.message, 0, 255);
-    strcpy(data.message, message);
+    strncpy(data.message, message, sizeof(data.message) - 1);
 
     data.pid = pid;
     data.port = port;
 
     return data;
 }
+
+ssize_t mipc_process_sendv(int fd, const struct mipc_process_request_t* request, const struct iovec* segments, int count) {
+    if (!request || !segments || count <= 0 || count > MIPC_SEGMENT_MAX) {
+        printerr("invalid segments for send");
+        return -1;
+    }
+
+    struct iovec iov[MIPC_SEGMENT_MAX + 1];
+    char header[512];
+    int len = snprintf(header, sizeof(header), "v ");
+
+    for (int i = 0; i < count; i++) {
+        len += snprintf(header + len, sizeof(header) - len, i ? ",%zu" : "%zu", segments[i].iov_len);
+    }
+
+    len += snprintf(header + len,
+                    sizeof(header) - len,
+                    " {.message=%s,.pid=%u,.port=%u}\n",
+                    request->message,
+                    request->pid,
+                    request->port);
+
+    if (len >= (int)sizeof(header)) {
+        printerr("vector header too long");
+        return -1;
+    }
+
+    iov[0].iov_base = header;
+    iov[0].iov_len = len;
+    memcpy(&iov[1], segments, count * sizeof(struct iovec));
+
+    /* the kernel gathers the segments, they are never joined in user space */
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(struct msghdr));
+
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count + 1;
+
+    return sendmsg(fd, &msg, 0);
+}
+
+int64_t mipc_process_stamp(int fd) {
+    char frame[32];
+    char response[255];
+    int len = snprintf(frame, sizeof(frame), "t %llu", (unsigned long long)timenow());
+
+    if (send(fd, frame, len, 0) != len || recv(fd, response, 255, MSG_WAITALL) != 255) {
+        err("could not send stamp");
+        return -1;
+    }
+
+    if (strncmp(response, "stamp: ", 7) != 0) {
+        return -1;
+    }
+
+    return strtoll(response + 7, NULL, 10);
+}
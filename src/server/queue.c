@@ -0,0 +1,180 @@
+/**
+ * This file is part of the microipc distribution (https://github.com/MustafaMalikDev/microipc)
+ * Copyright (c) 2025 Mustafa Malik.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/queue.h"
+
+#include "config.h"
+#include <errno.h>
+#include <string.h>
+
+#define MIPC_QUEUE_MASK (MIPC_QUEUE_DEPTH - 1)
+
+/* private but stable libsystem_kernel entry points, the same ones libc++ uses for atomic waits */
+#define MIPC_UL_COMPARE_AND_WAIT 1
+#define MIPC_ULF_WAKE_ALL 0x00000100
+
+extern int __ulock_wait(uint32_t, void*, uint64_t, uint32_t);
+extern int __ulock_wake(uint32_t, void*, uint64_t);
+
+typedef int (*mipc_queue_pop_fn)(void*, struct mipc_queue_msg_t*);
+
+static void g_mipc_queue_notify(struct mipc_queue_event_t* event) {
+    __atomic_fetch_add(&event->seq, 1, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&event->waiters, __ATOMIC_SEQ_CST)) {
+        __ulock_wake(MIPC_UL_COMPARE_AND_WAIT | MIPC_ULF_WAKE_ALL, &event->seq, 0);
+    }
+}
+
+/* timeout is in microseconds, 0 waits forever */
+static int g_mipc_queue_pop_wait(struct mipc_queue_event_t* event,
+                                 mipc_queue_pop_fn pop,
+                                 void* queue,
+                                 struct mipc_queue_msg_t* msg,
+                                 uint32_t timeout) {
+    int result = FALSE;
+
+    __atomic_fetch_add(&event->waiters, 1, __ATOMIC_SEQ_CST);
+
+    while (TRUE) {
+        uint32_t seen = __atomic_load_n(&event->seq, __ATOMIC_SEQ_CST);
+
+        if (pop(queue, msg)) {
+            result = TRUE;
+            break;
+        }
+
+        if (__ulock_wait(MIPC_UL_COMPARE_AND_WAIT, &event->seq, seen, timeout) == -1 && errno == ETIMEDOUT) {
+            result = pop(queue, msg);
+            break;
+        }
+    }
+
+    __atomic_fetch_sub(&event->waiters, 1, __ATOMIC_SEQ_CST);
+    return result;
+}
+
+static int g_mipc_queue_spsc_pop(void* queue, struct mipc_queue_msg_t* msg) {
+    return mipc_queue_spsc_pop((struct mipc_queue_spsc_t*)queue, msg);
+}
+
+static int g_mipc_queue_mpsc_pop(void* queue, struct mipc_queue_msg_t* msg) {
+    return mipc_queue_mpsc_pop((struct mipc_queue_mpsc_t*)queue, msg);
+}
+
+void mipc_queue_spsc_init(struct mipc_queue_spsc_t* queue) {
+    memset(queue, 0, sizeof(struct mipc_queue_spsc_t));
+}
+
+int mipc_queue_spsc_push(struct mipc_queue_spsc_t* queue, const struct mipc_queue_msg_t* msg) {
+    uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+    uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+
+    if (tail - head >= MIPC_QUEUE_DEPTH) {
+        return FALSE;
+    }
+
+    queue->slots[tail & MIPC_QUEUE_MASK] = *msg;
+    __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+
+    g_mipc_queue_notify(&queue->event);
+    return TRUE;
+}
+
+int mipc_queue_spsc_pop(struct mipc_queue_spsc_t* queue, struct mipc_queue_msg_t* msg) {
+    uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+
+    if (head == tail) {
+        return FALSE;
+    }
+
+    *msg = queue->slots[head & MIPC_QUEUE_MASK];
+    __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+
+    return TRUE;
+}
+
+int mipc_queue_spsc_pop_wait(struct mipc_queue_spsc_t* queue, struct mipc_queue_msg_t* msg, uint32_t timeout) {
+    if (mipc_queue_spsc_pop(queue, msg)) {
+        return TRUE;
+    }
+
+    return g_mipc_queue_pop_wait(&queue->event, g_mipc_queue_spsc_pop, queue, msg, timeout);
+}
+
+void mipc_queue_mpsc_init(struct mipc_queue_mpsc_t* queue) {
+    memset(queue, 0, sizeof(struct mipc_queue_mpsc_t));
+
+    for (uint32_t i = 0; i < MIPC_QUEUE_DEPTH; i++) {
+        queue->seq[i] = i;
+    }
+}
+
+/*
+    bounded ring with a sequence number per slot: a producer claims a position
+    with a CAS on the tail and publishes it by bumping the slot sequence, so the
+    consumer never observes a half written message
+*/
+int mipc_queue_mpsc_push(struct mipc_queue_mpsc_t* queue, const struct mipc_queue_msg_t* msg) {
+    uint32_t pos = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+
+    while (TRUE) {
+        uint32_t seq = __atomic_load_n(&queue->seq[pos & MIPC_QUEUE_MASK], __ATOMIC_ACQUIRE);
+        int32_t diff = (int32_t)(seq - pos);
+
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(
+                    &queue->tail, &pos, pos + 1, TRUE, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return FALSE; /* full */
+        } else {
+            pos = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    queue->slots[pos & MIPC_QUEUE_MASK] = *msg;
+    __atomic_store_n(&queue->seq[pos & MIPC_QUEUE_MASK], pos + 1, __ATOMIC_RELEASE);
+
+    g_mipc_queue_notify(&queue->event);
+    return TRUE;
+}
+
+int mipc_queue_mpsc_pop(struct mipc_queue_mpsc_t* queue, struct mipc_queue_msg_t* msg) {
+    uint32_t pos = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+    uint32_t seq = __atomic_load_n(&queue->seq[pos & MIPC_QUEUE_MASK], __ATOMIC_ACQUIRE);
+
+    if ((int32_t)(seq - (pos + 1)) < 0) {
+        return FALSE;
+    }
+
+    *msg = queue->slots[pos & MIPC_QUEUE_MASK];
+    __atomic_store_n(&queue->seq[pos & MIPC_QUEUE_MASK], pos + MIPC_QUEUE_DEPTH, __ATOMIC_RELEASE);
+    __atomic_store_n(&queue->head, pos + 1, __ATOMIC_RELAXED);
+
+    return TRUE;
+}
+
+int mipc_queue_mpsc_pop_wait(struct mipc_queue_mpsc_t* queue, struct mipc_queue_msg_t* msg, uint32_t timeout) {
+    if (mipc_queue_mpsc_pop(queue, msg)) {
+        return TRUE;
+    }
+
+    return g_mipc_queue_pop_wait(&queue->event, g_mipc_queue_mpsc_pop, queue, msg, timeout);
+}
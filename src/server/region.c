@@ -0,0 +1,140 @@
+/**
+ * This file is part of the microipc distribution (https://github.com/MustafaMalikDev/microipc)
+ * Copyright (c) 2025 Mustafa Malik.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIPC_USE_LIBS
+#define MIPC_USE_STD
+
+#include "server/region.h"
+
+#include "config.h"
+
+#include <mach/vm_statistics.h>
+#include <string.h>
+#include <sys/mman.h>
+
+static char* g_region = NULL;
+static size_t g_region_size = 0;
+static size_t g_region_used = 0;
+static int g_region_locked = FALSE;
+
+static void* g_mipc_region_map(size_t size, int flags) {
+    void* region = MAP_FAILED;
+
+    if (flags & MIPC_REGION_HUGEPAGES) {
+        /* darwin takes the superpage request through the fd argument of an anonymous mapping */
+        region = mmap(NULL,
+                      size,
+                      PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANON,
+                      VM_FLAGS_SUPERPAGE_SIZE_ANY,
+                      0);
+
+        if (region == MAP_FAILED) {
+            printerr("superpages are not available, using regular pages");
+        }
+    }
+
+    if (region == MAP_FAILED) {
+        region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+    }
+
+    return region;
+}
+
+int mipc_region_init(size_t size, int flags) {
+    if (g_region) {
+        return FALSE;
+    }
+
+    size_t page = (size_t)getpagesize();
+
+    size = size ? size : MIPC_REGION_DEFAULT_SIZE;
+    size = (size + page - 1) & ~(page - 1);
+
+    void* region = g_mipc_region_map(size, flags);
+    if (region == MAP_FAILED) {
+        err("could not map server region");
+        return FALSE;
+    }
+
+    if (flags & MIPC_REGION_PREFAULT) {
+        for (size_t offset = 0; offset < size; offset += page) {
+            ((volatile char*)region)[offset] = 0;
+        }
+    }
+
+    if (flags & MIPC_REGION_LOCK) {
+        if (mlock(region, size) == -1) {
+            err("could not lock server region");
+        } else {
+            g_region_locked = TRUE;
+        }
+    }
+
+    g_region = region;
+    g_region_size = size;
+    g_region_used = 0;
+    return TRUE;
+}
+
+void* mipc_region_alloc(size_t size) {
+    if (!g_region) {
+        return calloc(1, size);
+    }
+
+    size_t start = (g_region_used + MIPC_REGION_ALIGN - 1) & ~((size_t)MIPC_REGION_ALIGN - 1);
+
+    if (start + size > g_region_size) {
+        printerr("server region exhausted, falling back to the heap");
+        return calloc(1, size);
+    }
+
+    g_region_used = start + size;
+    return g_region + start;
+}
+
+void mipc_region_free(void* memory) {
+    char* address = memory;
+
+    /* a region allocation goes away with the region, a heap fallback has to be freed */
+    if (g_region && address >= g_region && address < g_region + g_region_size) {
+        return;
+    }
+
+    free(memory);
+}
+
+int mipc_region_active(void) {
+    return g_region != NULL;
+}
+
+void mipc_region_destroy(void) {
+    if (!g_region) {
+        return;
+    }
+
+    if (g_region_locked) {
+        munlock(g_region, g_region_size);
+    }
+
+    munmap(g_region, g_region_size);
+
+    g_region = NULL;
+    g_region_size = 0;
+    g_region_used = 0;
+    g_region_locked = FALSE;
+}
@@ -0,0 +1,240 @@
+/**
+ * This file is part of the microipc distribution (https://github.com/MustafaMalikDev/microipc)
+ * Copyright (c) 2025 Mustafa Malik.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIPC_USE_LIBS
+#define MIPC_USE_STD
+
+#include "server/registry.h"
+#include "server/group.h"
+#include "server/table.h"
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static struct mipc_registry_t* g_published = NULL; /* writable mapping in the "Kernel" */
+static const struct mipc_registry_t* g_attached = NULL; /* read-only mapping in a client */
+
+static void g_mipc_registry_store(struct mipc_registry_slot_t* slot, uint32_t port, uint32_t pid) {
+    __atomic_store_n(&slot->port, port, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->pid, pid, __ATOMIC_RELAXED);
+}
+
+/* copies a consistent view of the registry, retrying while the "Kernel" is mid update */
+static void g_mipc_registry_load(struct mipc_registry_slot_t* copy, const struct mipc_registry_slot_t* slot) {
+    copy->port = __atomic_load_n(&slot->port, __ATOMIC_RELAXED);
+    copy->pid = __atomic_load_n(&slot->pid, __ATOMIC_RELAXED);
+}
+
+static void g_mipc_registry_snapshot(struct mipc_registry_t* snapshot) {
+    uint32_t before;
+    uint32_t after;
+
+    do {
+        before = __atomic_load_n(&g_attached->seq, __ATOMIC_ACQUIRE);
+
+        for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
+            g_mipc_registry_load(&snapshot->processes[i], &g_attached->processes[i]);
+            g_mipc_registry_load(&snapshot->links[i], &g_attached->links[i]);
+        }
+
+        for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS * MIPC_MAX_POLL_FDS; i++) {
+            g_mipc_registry_load(&snapshot->members[i], &g_attached->members[i]);
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&g_attached->seq, __ATOMIC_RELAXED);
+    } while ((before & 1) || before != after);
+}
+
+int mipc_registry_create(void) {
+    if (g_published) {
+        return TRUE;
+    }
+
+    int fd = shm_open(MIPC_REGISTRY_NAME, O_RDWR | O_CREAT, 0644);
+    if (fd == -1) {
+        err("could not create shared registry");
+        return FALSE;
+    }
+
+    if (ftruncate(fd, sizeof(struct mipc_registry_t)) == -1) {
+        /* darwin only allows sizing a shared memory object once, reuse it if it's already right */
+        struct stat info;
+
+        if (fstat(fd, &info) == -1 || (size_t)info.st_size < sizeof(struct mipc_registry_t)) {
+            err("could not size shared registry");
+            close(fd);
+            return FALSE;
+        }
+    }
+
+    void* region = mmap(NULL, sizeof(struct mipc_registry_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (region == MAP_FAILED) {
+        err("could not map shared registry");
+        return FALSE;
+    }
+
+    g_published = region;
+    memset(g_published, 0, sizeof(struct mipc_registry_t));
+    __atomic_store_n(&g_published->magic, MIPC_REGISTRY_MAGIC, __ATOMIC_RELEASE);
+
+    return TRUE;
+}
+
+void mipc_registry_publish(const struct mipc_table_t* table) {
+    if (!g_published || !table) {
+        return;
+    }
+
+    /* odd while writing, readers retry until it's even and unchanged */
+    __atomic_fetch_add(&g_published->seq, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
+        const struct mipc_process_request_t* process = &table->proc_entry.process[i];
+        const struct mipc_process_mailbox_t* queue = &table->mail_entry.queue[i];
+
+        g_mipc_registry_store(&g_published->processes[i], process->port, process->pid);
+        g_mipc_registry_store(&g_published->links[i], queue->first.port, queue->second.pid);
+    }
+
+    __atomic_fetch_add(&g_published->seq, 1, __ATOMIC_RELEASE);
+}
+
+void mipc_registry_publish_groups(const struct mipc_group_t* groups, uint8_t count) {
+    uint8_t slot = 0;
+
+    if (!g_published || !groups) {
+        return;
+    }
+
+    __atomic_fetch_add(&g_published->seq, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    for (uint8_t i = 0; i < count; i++) {
+        for (uint8_t j = 0; j < groups[i].count && slot < MIPC_MAX_POLL_FDS * MIPC_MAX_POLL_FDS; j++) {
+            g_mipc_registry_store(&g_published->members[slot++], groups[i].port, groups[i].members[j].pid);
+        }
+    }
+
+    /* members that left leave empty slots behind */
+    while (slot < MIPC_MAX_POLL_FDS * MIPC_MAX_POLL_FDS) {
+        g_mipc_registry_store(&g_published->members[slot++], 0, 0);
+    }
+
+    __atomic_fetch_add(&g_published->seq, 1, __ATOMIC_RELEASE);
+}
+
+void mipc_registry_destroy(void) {
+    if (!g_published) {
+        return;
+    }
+
+    munmap(g_published, sizeof(struct mipc_registry_t));
+    shm_unlink(MIPC_REGISTRY_NAME);
+    g_published = NULL;
+}
+
+int mipc_registry_attach(void) {
+    if (g_attached) {
+        return TRUE;
+    }
+
+    int fd = shm_open(MIPC_REGISTRY_NAME, O_RDONLY, 0);
+    if (fd == -1) {
+        err("could not open shared registry, is the kernel running?");
+        return FALSE;
+    }
+
+    void* region = mmap(NULL, sizeof(struct mipc_registry_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (region == MAP_FAILED) {
+        err("could not map shared registry");
+        return FALSE;
+    }
+
+    if (((const struct mipc_registry_t*)region)->magic != MIPC_REGISTRY_MAGIC) {
+        printerr("shared registry is not initialised");
+        munmap(region, sizeof(struct mipc_registry_t));
+        return FALSE;
+    }
+
+    g_attached = region;
+    return TRUE;
+}
+
+/*
+    a registered port is either waiting in the process table, was shifted into a
+    mailbox queue or has service group members
+*/
+int mipc_registry_contains(uint32_t port) {
+    struct mipc_registry_t snapshot;
+
+    if (!g_attached || !port) {
+        return FALSE;
+    }
+
+    g_mipc_registry_snapshot(&snapshot);
+
+    for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
+        if (snapshot.processes[i].port == port || snapshot.links[i].port == port) {
+            return TRUE;
+        }
+    }
+
+    for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS * MIPC_MAX_POLL_FDS; i++) {
+        if (snapshot.members[i].port == port) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+int mipc_registry_linked(uint32_t port, uint32_t pid) {
+    struct mipc_registry_t snapshot;
+
+    if (!g_attached || !port || !pid) {
+        return FALSE;
+    }
+
+    g_mipc_registry_snapshot(&snapshot);
+
+    for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
+        if (snapshot.links[i].port == port && snapshot.links[i].pid == pid) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+void mipc_registry_detach(void) {
+    if (!g_attached) {
+        return;
+    }
+
+    munmap((void*)g_attached, sizeof(struct mipc_registry_t));
+    g_attached = NULL;
+}
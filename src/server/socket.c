@@ -19,15 +19,26 @@
 #define MIPC_USE_STD
 
 #include "server/socket.h"
+#include "server/command.h"
 #include "server/dispatch.h"
-#include "server/process.h"
+#include "server/limit.h"
+#include "server/packet.h"
+#include "server/probes.h"
+#include "server/region.h"
+#include "server/registry.h"
 #include "server/table.h"
+#include "server/trace.h"
 
 #include "config.h"
-#include "strutil.h"
+#include "timeutil.h"
 
+#include <mach/mach.h>
+#include <mach/thread_policy.h>
+#include <pthread.h>
+#include <pthread/qos.h>
 #include <string.h>
 #include <sys/event.h>
+#include <sys/stat.h>
 
 static char* g_socket_name;
 static int g_buffer_size;
@@ -35,6 +46,254 @@ static int g_ready = FALSE;
 static int g_running = FALSE;
 static int g_socket = -1;
 
+/* the message preserving listener, packet.c remembers which accepted connections came from it */
+static const char* g_packet_name = NULL;
+static int g_packet = -1;
+
+/* connections accepted here may change the limits, the socket file is only open to the server's user */
+static const char* g_control_name = NULL;
+static int g_control = -1;
+
+static int g_poll_mode = MIPC_POLL_BLOCK;
+static unsigned int g_poll_spin = MIPC_POLL_DEFAULT_SPIN;
+static int g_cpu = -1;
+static int g_priority = 0;
+
+/*
+    time from kevent handing back a readable client to the command running on it, only
+    the wait behind other events of the same wakeup, the same in every poll mode
+*/
+static uint64_t g_dispatch_count = 0;
+static uint64_t g_dispatch_total = 0;
+static uint64_t g_dispatch_max = 0;
+static uint64_t g_wakeup = 0;
+static uint64_t g_deferred = 0;
+
+static const char* g_poll_names[] = {"block", "busy", "adaptive"};
+
+static void g_mipc_socket_apply_affinity(void) {
+    if (g_cpu >= 0) {
+        /*
+            darwin has no hard pinning, an affinity tag is a placement hint and
+            is not supported at all on Apple silicon, so the loop also asks for
+            the highest QoS class which keeps it on the performance cores
+        */
+        thread_affinity_policy_data_t policy = {.affinity_tag = g_cpu + 1};
+        kern_return_t result = thread_policy_set(
+            mach_thread_self(), THREAD_AFFINITY_POLICY, (thread_policy_t)&policy, THREAD_AFFINITY_POLICY_COUNT);
+
+        if (result != KERN_SUCCESS) {
+            printerr("cpu affinity is not supported here, using the performance cores instead");
+        }
+
+        if (pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0) != 0) {
+            printerr("could not raise the loop QoS class");
+        }
+    }
+
+    if (g_priority > 0) {
+        struct sched_param param = {.sched_priority = g_priority};
+
+        if (pthread_setschedparam(pthread_self(), SCHED_RR, &param) != 0) {
+            err("could not set loop thread priority");
+        }
+    }
+}
+
+static int g_mipc_socket_poll(int kq, struct kevent* events) {
+    static const struct timespec zero = {0, 0};
+    int next_ev = 0;
+
+    if (g_poll_mode == MIPC_POLL_BUSY) {
+        while (g_running && !next_ev) {
+            next_ev = kevent(kq, NULL, 0, events, MIPC_MAX_POLL_FDS, &zero);
+        }
+
+        return next_ev;
+    }
+
+    if (g_poll_mode == MIPC_POLL_ADAPTIVE) {
+        for (unsigned int spin = 0; spin < g_poll_spin && g_running; spin++) {
+            next_ev = kevent(kq, NULL, 0, events, MIPC_MAX_POLL_FDS, &zero);
+
+            if (next_ev) {
+                return next_ev;
+            }
+        }
+    }
+
+    return kevent(kq, NULL, 0, events, MIPC_MAX_POLL_FDS, NULL);
+}
+
+/* every frame is recorded before it is admitted, a replay has to send the rejected ones too */
+static void g_mipc_socket_receive(int fd, char* frame, ssize_t len) {
+    MIPC_PROBE(RECV, fd, 0, 0, len);
+    mipc_trace_record(MIPC_TRACE_RECV, fd, frame, len);
+}
+
+static void g_mipc_socket_dispatch(int fd, char* frame, ssize_t len) {
+    uint64_t latency = timenow() - g_wakeup;
+
+    g_dispatch_count++;
+    g_dispatch_total += latency;
+    g_dispatch_max = latency > g_dispatch_max ? latency : g_dispatch_max;
+
+    mipc_command_execute(fd, frame, len);
+}
+
+/* reject mode: the frame has been read but is answered straight away instead of running */
+static int g_mipc_socket_over_limit(int fd, char* frame, ssize_t len) {
+    if (!mipc_limit_conn_admit(fd, len)) {
+        return FALSE;
+    }
+
+    mipc_command_reject(fd, frame, len, "connection over its rate limit");
+    return TRUE;
+}
+
+/*
+    defer mode: a stream connection over its budget is not read again until the
+    budget refills, packets are always charged one by one after the batch read
+*/
+static int g_mipc_socket_defer(int kq, const struct kevent* event, size_t max) {
+    if (mipc_limit_mode() != MIPC_LIMIT_DEFER) {
+        return FALSE;
+    }
+
+    size_t pending = event->data > 0 ? (size_t)event->data : 0;
+    uint64_t wait = mipc_limit_conn_admit(event->ident, pending < max ? pending : max);
+
+    if (!wait || wait == UINT64_MAX) {
+        return FALSE;
+    }
+
+    struct kevent changes[2];
+    EV_SET(&changes[0], event->ident, EVFILT_READ, EV_DISABLE, 0, 0, NULL);
+    EV_SET(&changes[1], event->ident, EVFILT_TIMER, EV_ADD | EV_ONESHOT, NOTE_NSECONDS, wait, NULL);
+
+    if (kevent(kq, changes, 2, NULL, 0, NULL) == -1) {
+        err("could not defer client");
+        return FALSE;
+    }
+
+    g_deferred++;
+    return TRUE;
+}
+
+/* every packet is exactly one command, a zero length means a datagram peer went away */
+static void g_mipc_socket_on_packet(int fd, char* frame, ssize_t len) {
+    if (len <= 0) {
+        MIPC_PROBE(DISCONNECT, fd, 0, 0, 0);
+        mipc_trace_record(MIPC_TRACE_CLOSE, fd, NULL, 0);
+        mipc_command_disconnect(fd);
+        return;
+    }
+
+    /* a datagram's fd is the reply socket, nothing may ever be read from it */
+    if (!mipc_command_complete(frame, len)) {
+        printerr("stream or vector body doesn't match its packet, discarding frame");
+        return;
+    }
+
+    g_mipc_socket_receive(fd, frame, len);
+
+    if (g_mipc_socket_over_limit(fd, frame, len)) {
+        return;
+    }
+
+    g_mipc_socket_dispatch(fd, frame, len);
+}
+
+static int g_mipc_socket_accept(int kq, int listener, int packet) {
+    struct kevent event;
+    int fd = accept(listener, NULL, NULL);
+
+    if (fd == -1) {
+        err("failed to accept connection from client");
+        return -1;
+    }
+
+    /*
+        the connection never makes it into the trace, its rejection isn't recorded either.
+        the control socket is left out of the cap so the limits can always be changed
+    */
+    if (listener != g_control && !mipc_limit_open(fd)) {
+        mipc_limit_reject(fd, "connection limit reached");
+        close(fd);
+        return -1;
+    }
+
+    if (packet && !mipc_packet_adopt(fd)) {
+        mipc_limit_close(fd);
+        close(fd);
+        return -1;
+    }
+
+#ifdef SO_NOSIGPIPE
+    /* a stream relay writes to receivers that may already be gone */
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+    MIPC_PROBE(ACCEPT, fd, 0, 0, 0);
+    mipc_trace_record(MIPC_TRACE_OPEN, fd, NULL, 0);
+
+    EV_SET(&event, fd, EVFILT_READ, EV_ADD, 0, 0, NULL);
+
+    if (kevent(kq, &event, 1, NULL, 0, NULL) == -1) {
+        err("could not handle new client connection");
+    }
+
+    return fd;
+}
+
+static int g_mipc_socket_control_listen(int kq) {
+    struct kevent event;
+    struct sockaddr_un name;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd == -1) {
+        err("could not create control socket");
+        return -1;
+    }
+
+    memset(&name, 0, sizeof(struct sockaddr_un));
+
+    name.sun_family = AF_UNIX;
+    name.sun_len = MIPC_SUN_SOCK_LEN + 1;
+    strncpy(name.sun_path, g_control_name, MIPC_SUN_SOCK_LEN);
+
+    unlink(g_control_name);
+
+    /* the file is created 0600 straight away, nobody else can connect in between */
+    mode_t mask = umask(S_IXUSR | S_IRWXG | S_IRWXO);
+    int result = bind(fd, (const struct sockaddr*)&name, sizeof(struct sockaddr_un));
+    umask(mask);
+
+    EV_SET(&event, fd, EVFILT_READ, EV_ADD, 0, 0, NULL);
+
+    if (result == -1 || listen(fd, MIPC_MAX_POLL_FDS) == -1 || kevent(kq, &event, 1, NULL, 0, NULL) == -1) {
+        err("could not listen on the control socket");
+        close(fd);
+        unlink(g_control_name);
+        return -1;
+    }
+
+    return fd;
+}
+
+static void g_mipc_socket_print_stats(void) {
+    if (!g_dispatch_count) {
+        return;
+    }
+
+    printf("[POLL]: mode %s, %llu dispatches, kevent return to dispatch avg %.2fus max %.2fus\n",
+           g_poll_names[g_poll_mode],
+           (unsigned long long)g_dispatch_count,
+           (double)g_dispatch_total / g_dispatch_count / MIPC_NS_PER_USEC,
+           (double)g_dispatch_max / MIPC_NS_PER_USEC);
+}
+
 int mipc_socket_create(const char* name, int size) {
     if (!name || size <= 0 || g_ready || g_running) {
         return FALSE;
@@ -54,12 +313,61 @@ int mipc_socket_create(const char* name, int size) {
     return TRUE;
 }
 
+int mipc_socket_set_poll(int mode, unsigned int spin) {
+    if (g_running || mode < MIPC_POLL_BLOCK || mode > MIPC_POLL_ADAPTIVE) {
+        return FALSE;
+    }
+
+    g_poll_mode = mode;
+    g_poll_spin = spin ? spin : MIPC_POLL_DEFAULT_SPIN;
+    return TRUE;
+}
+
+int mipc_socket_set_affinity(int cpu, int priority) {
+    if (g_running || priority < 0) {
+        return FALSE;
+    }
+
+    g_cpu = cpu;
+    g_priority = priority;
+    return TRUE;
+}
+
+int mipc_socket_set_packet(const char* name) {
+    if (!name || g_running) {
+        return FALSE;
+    }
+
+    if (strlen(name) > MIPC_SUN_SOCK_LEN) {
+        printerr("name too long");
+        return FALSE;
+    }
+
+    g_packet_name = name;
+    return TRUE;
+}
+
+int mipc_socket_set_control(const char* name) {
+    if (!name || g_running) {
+        return FALSE;
+    }
+
+    if (strlen(name) > MIPC_SUN_SOCK_LEN) {
+        printerr("name too long");
+        return FALSE;
+    }
+
+    g_control_name = name;
+    return TRUE;
+}
+
 int mipc_socket_start(void) {
     if (!g_ready || g_running) {
         return FALSE;
     }
 
-    char buffer[MIPC_MAX_POLL_FDS][g_buffer_size];
+    /* the connection buffers live in the server region when there is one, they come back zeroed */
+    char(*buffer)[g_buffer_size] = mipc_region_alloc(MIPC_MAX_POLL_FDS * (size_t)g_buffer_size);
     int kq = kqueue();
     int next_ev = -1;
     int data = 0;
@@ -68,8 +376,9 @@ int mipc_socket_start(void) {
     struct kevent event;
     struct sockaddr_un name;
 
-    for (int i = 0; i < MIPC_MAX_POLL_FDS; i++) {
-        memset(buffer[i], 0, sizeof(buffer[i]));
+    if (!buffer || !mipc_table_init() || !mipc_dispatch_init(g_buffer_size)) {
+        printerr("could not allocate server memory");
+        return FALSE;
     }
 
     g_socket = socket(AF_UNIX, SOCK_STREAM, 0);
@@ -105,9 +414,38 @@ int mipc_socket_start(void) {
         return FALSE;
     }
 
+    if (g_packet_name) {
+        g_packet = mipc_packet_listen(g_packet_name, g_buffer_size);
+        EV_SET(&event, g_packet, EVFILT_READ, EV_ADD, 0, 0, NULL);
+
+        if (g_packet == -1 || kevent(kq, &event, 1, NULL, 0, NULL) == -1) {
+            printerr("could not start the packet listener");
+            mipc_packet_close();
+            mipc_socket_stop(SIGTERM);
+            return FALSE;
+        }
+    }
+
+    if (g_control_name && (g_control = g_mipc_socket_control_listen(kq)) == -1) {
+        mipc_packet_close();
+        mipc_socket_stop(SIGTERM);
+        return FALSE;
+    }
+
+    /*
+        only created once every listener is up, so no error path above has to take it
+        down again. clients can still talk to the "Kernel" without it, they just can't
+        look ports up locally
+    */
+    mipc_registry_create();
+
     g_running = TRUE;
     result = 0;
 
+    mipc_dispatch_set_queue(kq);
+
+    g_mipc_socket_apply_affinity();
+
     struct kevent eset;
     struct kevent events[MIPC_MAX_POLL_FDS];
     int clients[MIPC_MAX_POLL_FDS];
@@ -115,14 +453,25 @@ int mipc_socket_start(void) {
 
     memset(clients, -1, MIPC_MAX_POLL_FDS);
     while (g_running) {
-        next_ev = kevent(kq, NULL, 0, events, MIPC_MAX_POLL_FDS, NULL);
+        next_ev = g_mipc_socket_poll(kq, events);
+        g_wakeup = timenow();
 
-        if (next_ev < 1) {
+        if (next_ev < 1 && g_running) {
             err("failed to read kernel event in loop");
         }
 
         for (int i = 0; i < next_ev; i++) {
-            if (events[i].flags & EV_EOF) {
+            if (events[i].filter == EVFILT_TIMER) {
+                /* the budget of a deferred client refilled, start reading it again */
+                EV_SET(&eset, events[i].ident, EVFILT_READ, EV_ENABLE, 0, 0, NULL);
+                kevent(kq, &eset, 1, NULL, 0, NULL);
+            } else if (events[i].filter == EVFILT_WRITE) {
+                /* only a stream relay waits for a receiver to drain */
+                mipc_dispatch_stream_event(events[i].ident, EVFILT_WRITE);
+            } else if (mipc_dispatch_stream_event(events[i].ident, EVFILT_READ)) {
+                /* the next chunk of a stream body, the sender's close is seen once its relay is done */
+                continue;
+            } else if (events[i].flags & EV_EOF) {
                 println("client disconnect request acknowledged");
 
                 fd = events[i].ident;
@@ -133,71 +482,44 @@ int mipc_socket_start(void) {
                     continue;
                 }
 
+                /* a client can go away while it is deferred */
+                EV_SET(&eset, fd, EVFILT_TIMER, EV_DELETE, 0, 0, NULL);
+                kevent(kq, &eset, 1, NULL, 0, NULL);
+                EV_SET(&eset, fd, EVFILT_WRITE, EV_DELETE, 0, 0, NULL);
+                kevent(kq, &eset, 1, NULL, 0, NULL);
+
                 memset(buffer[i], 0, sizeof(buffer[i]));
+                MIPC_PROBE(DISCONNECT, fd, 0, 0, 0);
+                mipc_trace_record(MIPC_TRACE_CLOSE, fd, NULL, 0);
+                mipc_command_disconnect(fd);
+                mipc_packet_release(fd);
                 clients[i] = -1;
                 close(fd);
             } else if (events[i].ident == (uintptr_t)g_socket) {
-                fd = accept(events[i].ident, NULL, NULL);
+                clients[i] = g_mipc_socket_accept(kq, g_socket, FALSE);
+            } else if (events[i].ident == (uintptr_t)g_control) {
+                clients[i] = g_mipc_socket_accept(kq, g_control, FALSE);
 
-                if (fd == -1) {
-                    err("failed to accept connection from client");
+                if (clients[i] != -1) {
+                    mipc_limit_authorise(clients[i]);
+                }
+            } else if (events[i].ident == (uintptr_t)g_packet && mipc_packet_connected()) {
+                clients[i] = g_mipc_socket_accept(kq, g_packet, TRUE);
+            } else if (events[i].ident == (uintptr_t)g_packet || mipc_packet_owns(events[i].ident)) {
+                /* the kernel kept the boundaries, drain a whole batch without any framing */
+                mipc_packet_recv(events[i].ident, g_mipc_socket_on_packet);
+            } else if (events[i].filter == EVFILT_READ) {
+                if (g_mipc_socket_defer(kq, &events[i], sizeof(buffer[i]) - 1)) {
                     continue;
                 }
 
-                clients[i] = fd;
-                EV_SET(&eset, fd, EVFILT_READ, EV_ADD, 0, 0, NULL);
-
-                if (kevent(kq, &eset, 1, NULL, 0, NULL) == -1) {
-                    err("could not handle new client connection");
-                }
-            } else if (events[i].filter == EVFILT_READ) {
-                data = recv(events[i].ident, buffer[i], sizeof(buffer[i]), 0);
+                data = recv(events[i].ident, buffer[i], sizeof(buffer[i]) - 1, 0);
                 if (data > 0) {
-                    const char* message = strtrim(buffer[i]);
-                    const char* copy = message;
-                    struct mipc_process_request_t request;
+                    g_mipc_socket_receive(events[i].ident, buffer[i], data);
 
-                    if (*message == 'c') {
-                        request = mipc_process_deserialise(strtrim((char*)++copy));
-                        mipc_table_insert(request);
-                    }
-
-                    if (*message == 'r') {
-                        request = mipc_process_deserialise(strtrim((char*)++copy));
-                        mipc_table_remove(request);
-                        mipc_table_destroy_queue(request);
-                        mipc_table_print_queue();
-                    }
-
-                    if (*message == '{') {
-                        request = mipc_process_deserialise(strtrim((char*)message));
-
-                        struct mipc_process_request_t target = MIPC_EMPTY_PROCESS();
-                        target.port = request.port;
-
-                        int port = target.port;
-                        int pid = request.pid;
-
-                        if (mipc_table_contains(target) > -1) {
-                            /*
-                                that means a request to an existing port exists,
-                                so we create a new mailbox queue with the target
-                            */
-                            if (mipc_table_queue_contains_both(port, pid) == -1) {
-                                mipc_table_shift_to_queue(target);
-                                mipc_table_map_to_queue(request);
-                                mipc_table_print_queue();
-                            } else {
-                                /* if they exist and are mapped, let's send some messages */
-                                if (mipc_dispatch_send_msg(port, pid, request.message)) {
-                                    struct mipc_process_mailbox_t* mailbox = mipc_table_get_mailbox(port, pid);
-                                    if (mailbox) {
-                                        println(mailbox->first.message);
-                                        write(events[i].ident, mailbox->second.message, 255);
-                                    }
-                                }
-                            }
-                        }
+                    if (mipc_limit_mode() == MIPC_LIMIT_DEFER ||
+                        !g_mipc_socket_over_limit(events[i].ident, buffer[i], data)) {
+                        g_mipc_socket_dispatch(events[i].ident, buffer[i], data);
                     }
 
                     memset(buffer[i], 0, sizeof(buffer[i]));
@@ -207,6 +529,18 @@ int mipc_socket_start(void) {
     }
 
     mipc_socket_stop(SIGTERM);
+    mipc_packet_close();
+    mipc_registry_destroy();
+    mipc_trace_close();
+    g_mipc_socket_print_stats();
+    mipc_command_print_stats();
+    mipc_limit_print_stats();
+
+    mipc_region_free(buffer);
+
+    /* last, the table, the relay chunks and the buffers may all live in it */
+    mipc_region_destroy();
+
     return TRUE;
 }
 
@@ -214,6 +548,12 @@ void mipc_socket_stop(int __attribute__((unused)) _) {
     unlink(g_socket_name);
     close(g_socket);
 
+    if (g_control != -1) {
+        unlink(g_control_name);
+        close(g_control);
+        g_control = -1;
+    }
+
     g_running = FALSE;
     g_ready = FALSE;
 }
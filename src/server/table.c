@@ -16,9 +16,41 @@
  */
 
 #include "server/table.h"
+#include "server/region.h"
+#include "server/registry.h"
 #include <string.h>
 
-static struct mipc_table_t g_table = {0};
+static struct mipc_table_t g_table_storage = {0};
+static struct mipc_table_t* g_table = &g_table_storage;
+static uint32_t g_generation = 0;
+
+/* any change can move a mailbox queue to another index, cached indices check the generation */
+static void g_mipc_table_changed(void) {
+    g_generation++;
+    mipc_registry_publish(g_table);
+}
+
+int mipc_table_init(void) {
+    if (!mipc_region_active()) {
+        g_mipc_table_changed();
+        return TRUE;
+    }
+
+    struct mipc_table_t* table = mipc_region_alloc(sizeof(struct mipc_table_t));
+    if (!table) {
+        return FALSE;
+    }
+
+    memcpy(table, g_table, sizeof(struct mipc_table_t));
+    g_table = table;
+
+    g_mipc_table_changed();
+    return TRUE;
+}
+
+uint32_t mipc_table_generation(void) {
+    return g_generation;
+}
 
 struct mipc_process_mailbox_t* mipc_table_get_mailbox(int port, int pid) {
     int8_t entry = mipc_table_queue_contains_both(port, pid);
@@ -27,7 +59,7 @@ struct mipc_process_mailbox_t* mipc_table_get_mailbox(int port, int pid) {
         return NULL;
     }
 
-    return &g_table.mail_entry.queue[entry];
+    return &g_table->mail_entry.queue[entry];
 }
 
 int8_t mipc_table_contains(const struct mipc_process_request_t request) {
@@ -41,8 +73,8 @@ int8_t mipc_table_contains(const struct mipc_process_request_t request) {
     for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
         /* clang-format off */
         if (
-            g_table.proc_entry.process[i].port == port ||
-            g_table.proc_entry.process[i].pid == request.pid
+            g_table->proc_entry.process[i].port == port ||
+            g_table->proc_entry.process[i].pid == request.pid
         ) {
             return i;
         }
@@ -52,18 +84,18 @@ int8_t mipc_table_contains(const struct mipc_process_request_t request) {
     return -1;
 }
 
-void mipc_table_insert(const struct mipc_process_request_t request) {
+int mipc_table_insert(const struct mipc_process_request_t request) {
     if (mipc_table_contains(request) >= 0) {
         printerr("cannot insert same process in entry");
-        return;
+        return FALSE;
     }
 
-    if (g_table.proc_entry.current >= MIPC_MAX_POLL_FDS) {
+    if (g_table->proc_entry.current >= MIPC_MAX_POLL_FDS) {
         printerr("maximum process table count reached");
-        return;
+        return FALSE;
     }
 
-    struct mipc_table_process_entry* proc_table = &g_table.proc_entry;
+    struct mipc_table_process_entry* proc_table = &g_table->proc_entry;
 
     if (proc_table->last != -1) {
         proc_table->process[proc_table->last] = request;
@@ -73,6 +105,9 @@ void mipc_table_insert(const struct mipc_process_request_t request) {
     }
 
     proc_table->current++;
+
+    g_mipc_table_changed();
+    return TRUE;
 }
 
 void mipc_table_update(const struct mipc_process_request_t request) {
@@ -83,34 +118,38 @@ void mipc_table_update(const struct mipc_process_request_t request) {
         return;
     }
 
-    g_table.proc_entry.process[index] = request;
+    g_table->proc_entry.process[index] = request;
+    g_mipc_table_changed();
 }
 
-void mipc_table_remove(const struct mipc_process_request_t request) {
+int mipc_table_remove(const struct mipc_process_request_t request) {
     int8_t index = mipc_table_contains(request);
 
     if (index == -1) {
         /* printerr("cannot remove process that doesn't exist in entry"); */
-        return;
+        return FALSE;
     }
 
-    memset(&g_table.proc_entry.process[index], 0, sizeof(struct mipc_process_request_t));
-    g_table.proc_entry.current--;
-    g_table.proc_entry.last = (index != (MIPC_MAX_POLL_FDS - 1)) ? index : -1;
+    memset(&g_table->proc_entry.process[index], 0, sizeof(struct mipc_process_request_t));
+    g_table->proc_entry.current--;
+    g_table->proc_entry.last = (index != (MIPC_MAX_POLL_FDS - 1)) ? index : -1;
+
+    g_mipc_table_changed();
+    return TRUE;
 }
 
 int8_t mipc_table_queue_contains(const struct mipc_process_request_t request) {
-    struct mipc_table_mailbox_entry mail_entry = g_table.mail_entry;
+    const struct mipc_table_mailbox_entry* mail_entry = &g_table->mail_entry;
     uint32_t port = request.port;
 
     for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
-        struct mipc_process_mailbox_t queue = mail_entry.queue[i];
+        const struct mipc_process_mailbox_t* queue = &mail_entry->queue[i];
 
-        if (!queue.first.port || !queue.second.pid) {
+        if (!queue->first.port || !queue->second.pid) {
             continue;
         }
 
-        if (queue.first.port == port || queue.second.pid == request.pid) {
+        if (queue->first.port == port || queue->second.pid == request.pid) {
             return TRUE;
         }
     }
@@ -123,11 +162,11 @@ int8_t mipc_table_queue_contains_both(uint32_t port, uint32_t pid) {
         return -1;
     }
 
-    struct mipc_table_mailbox_entry mail_entry = g_table.mail_entry;
+    const struct mipc_table_mailbox_entry* mail_entry = &g_table->mail_entry;
 
     for (int8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
-        struct mipc_process_mailbox_t queue = mail_entry.queue[i];
-        if (queue.first.port == port && queue.second.pid == pid) {
+        const struct mipc_process_mailbox_t* queue = &mail_entry->queue[i];
+        if (queue->first.port == port && queue->second.pid == pid) {
             return i;
         }
     }
@@ -142,17 +181,19 @@ void mipc_table_shift_to_queue(const struct mipc_process_request_t request) {
     }
 
     for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
-        struct mipc_process_request_t* first = &g_table.mail_entry.queue[i].first;
+        struct mipc_process_request_t* first = &g_table->mail_entry.queue[i].first;
         if (!first || !first->port) {
             mipc_table_remove(request);
             *first = request;
             break;
         }
     }
+
+    g_mipc_table_changed();
 }
 
 void mipc_table_map_to_queue(const struct mipc_process_request_t client) {
-    struct mipc_table_mailbox_entry* mail_entry = &g_table.mail_entry;
+    struct mipc_table_mailbox_entry* mail_entry = &g_table->mail_entry;
     uint32_t port = client.port;
 
     for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
@@ -163,6 +204,8 @@ void mipc_table_map_to_queue(const struct mipc_process_request_t client) {
             break;
         }
     }
+
+    g_mipc_table_changed();
 }
 
 void mipc_table_destroy_queue(const struct mipc_process_request_t request) {
@@ -170,42 +213,102 @@ void mipc_table_destroy_queue(const struct mipc_process_request_t request) {
         return;
     }
 
-    struct mipc_table_mailbox_entry mail_entry = g_table.mail_entry;
+    struct mipc_table_mailbox_entry* mail_entry = &g_table->mail_entry;
     struct mipc_process_mailbox_t tmp[MIPC_MAX_POLL_FDS];
 
     uint32_t port = request.port;
     uint8_t tmp_idx = 0;
 
     for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
-        struct mipc_process_request_t first = mail_entry.queue[i].first;
-        struct mipc_process_request_t second = mail_entry.queue[i].second;
+        const struct mipc_process_request_t* first = &mail_entry->queue[i].first;
+        const struct mipc_process_request_t* second = &mail_entry->queue[i].second;
 
-        if (first.port == port || second.pid == request.pid) {
-            memset(&g_table.mail_entry.queue[i], 0, sizeof(struct mipc_process_mailbox_t));
+        if (first->port == port || second->pid == request.pid) {
+            memset(&mail_entry->queue[i], 0, sizeof(struct mipc_process_mailbox_t));
         }
     }
 
     /* sorting */
     for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
-        if (mail_entry.queue[i].first.port) {
-            tmp[tmp_idx] = mail_entry.queue[i];
+        if (mail_entry->queue[i].first.port) {
+            tmp[tmp_idx] = mail_entry->queue[i];
             tmp_idx++;
         }
     }
 
-    memset(mail_entry.queue, 0, sizeof(struct mipc_table_mailbox_entry));
-    memcpy(mail_entry.queue, tmp, tmp_idx);
+    memset(mail_entry->queue, 0, sizeof(struct mipc_table_mailbox_entry));
+    memcpy(mail_entry->queue, tmp, tmp_idx * sizeof(struct mipc_process_mailbox_t));
+    g_mipc_table_changed();
     println("removed process from mailbox queue and destroyed all references");
 }
 
+int8_t mipc_table_link_queue(const struct mipc_process_request_t server, const struct mipc_process_request_t client) {
+    struct mipc_table_mailbox_entry* mail_entry = &g_table->mail_entry;
+
+    for (int8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
+        struct mipc_process_mailbox_t* queue = &mail_entry->queue[i];
+
+        if (!queue->first.port) {
+            queue->first = server;
+            queue->second = client;
+
+            g_mipc_table_changed();
+            return i;
+        }
+    }
+
+    printerr("maximum mailbox queue count reached");
+    return -1;
+}
+
+void mipc_table_rebind_queue(uint8_t index, const struct mipc_process_request_t server) {
+    if (index >= MIPC_MAX_POLL_FDS || !g_table->mail_entry.queue[index].first.port) {
+        return;
+    }
+
+    g_table->mail_entry.queue[index].first = server;
+    g_mipc_table_changed();
+}
+
+void mipc_table_pick_queue(uint8_t index, const struct mipc_process_request_t server) {
+    if (index >= MIPC_MAX_POLL_FDS || !g_table->mail_entry.queue[index].first.port) {
+        return;
+    }
+
+    g_table->mail_entry.queue[index].first = server;
+}
+
+struct mipc_process_mailbox_t* mipc_table_get_queue(uint8_t index) {
+    if (index >= MIPC_MAX_POLL_FDS) {
+        return NULL;
+    }
+
+    return &g_table->mail_entry.queue[index];
+}
+
+uint8_t mipc_table_queue_count(uint32_t port, uint32_t pid) {
+    const struct mipc_table_mailbox_entry* mail_entry = &g_table->mail_entry;
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
+        const struct mipc_process_mailbox_t* queue = &mail_entry->queue[i];
+
+        if (queue->first.port == port && queue->first.pid == pid && queue->second.pid) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
 void mipc_table_print_queue(void) {
-    struct mipc_table_mailbox_entry mail_entry = g_table.mail_entry;
+    const struct mipc_table_mailbox_entry* mail_entry = &g_table->mail_entry;
 
     for (uint8_t i = 0; i < MIPC_MAX_POLL_FDS; i++) {
-        struct mipc_process_request_t first = mail_entry.queue[i].first;
-        struct mipc_process_request_t second = mail_entry.queue[i].second;
+        const struct mipc_process_request_t* first = &mail_entry->queue[i].first;
+        const struct mipc_process_request_t* second = &mail_entry->queue[i].second;
 
-        printf("first %d\n", first.port);
-        printf("second %d\n", second.pid);
+        printf("first %d\n", first->port);
+        printf("second %d\n", second->pid);
     }
 }
@@ -0,0 +1,213 @@
+/**
+ * This file is part of the microipc distribution (https://github.com/MustafaMalikDev/microipc)
+ * Copyright (c) 2025 Mustafa Malik.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIPC_USE_LIBS
+#define MIPC_USE_STD
+
+#include "server/region.h"
+#include "server/trace.h"
+
+#include "config.h"
+#include "timeutil.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+
+/*
+    the loop only ever memcpy's into the active buffer, a full buffer is handed
+    to the writer thread and if that one is still busy the record is dropped
+    instead of stalling the loop on disk
+*/
+static char (*g_buffers)[MIPC_TRACE_BUFFER] = NULL;
+static int g_active = 0;
+static size_t g_used = 0;
+
+static int g_pending = FALSE;
+static int g_pending_index = 0;
+static size_t g_pending_len = 0;
+
+static int g_enabled = FALSE;
+static int g_stopping = FALSE;
+static int g_fd = -1;
+static uint64_t g_start = 0;
+static uint64_t g_dropped = 0;
+
+static pthread_t g_writer;
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cond = PTHREAD_COND_INITIALIZER;
+
+static void g_mipc_trace_write_all(const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t written = write(g_fd, data, len);
+
+        if (written <= 0) {
+            err("could not write trace file");
+            return;
+        }
+
+        data += written;
+        len -= written;
+    }
+}
+
+static void* g_mipc_trace_writer(void* _ __attribute__((unused))) {
+    pthread_mutex_lock(&g_lock);
+
+    while (TRUE) {
+        while (!g_pending && !g_stopping) {
+            pthread_cond_wait(&g_cond, &g_lock);
+        }
+
+        if (!g_pending) {
+            break;
+        }
+
+        int index = g_pending_index;
+        size_t len = g_pending_len;
+
+        pthread_mutex_unlock(&g_lock);
+        g_mipc_trace_write_all(g_buffers[index], len);
+        pthread_mutex_lock(&g_lock);
+
+        g_pending = FALSE;
+        pthread_cond_broadcast(&g_cond);
+    }
+
+    pthread_mutex_unlock(&g_lock);
+    return NULL;
+}
+
+/* hands the active buffer to the writer, fails if it hasn't finished the previous one */
+static int g_mipc_trace_swap(int wait) {
+    pthread_mutex_lock(&g_lock);
+
+    while (wait && g_pending) {
+        pthread_cond_wait(&g_cond, &g_lock);
+    }
+
+    if (g_pending) {
+        pthread_mutex_unlock(&g_lock);
+        return FALSE;
+    }
+
+    g_pending = TRUE;
+    g_pending_index = g_active;
+    g_pending_len = g_used;
+
+    g_active = !g_active;
+    g_used = 0;
+
+    pthread_cond_broadcast(&g_cond);
+    pthread_mutex_unlock(&g_lock);
+    return TRUE;
+}
+
+int mipc_trace_open(const char* path) {
+    if (!path || g_enabled) {
+        return FALSE;
+    }
+
+    if (!g_buffers) {
+        g_buffers = mipc_region_alloc(2 * MIPC_TRACE_BUFFER);
+
+        if (!g_buffers) {
+            printerr("could not allocate trace buffers");
+            return FALSE;
+        }
+    }
+
+    g_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (g_fd == -1) {
+        err("could not open trace file");
+        return FALSE;
+    }
+
+    memcpy(g_buffers[0], MIPC_TRACE_MAGIC, MIPC_TRACE_MAGIC_LEN);
+    g_active = 0;
+    g_used = MIPC_TRACE_MAGIC_LEN;
+    g_pending = FALSE;
+    g_stopping = FALSE;
+    g_dropped = 0;
+
+    if (pthread_create(&g_writer, NULL, g_mipc_trace_writer, NULL) != 0) {
+        printerr("could not start trace writer");
+        close(g_fd);
+        return FALSE;
+    }
+
+    g_start = timenow();
+    g_enabled = TRUE;
+    return TRUE;
+}
+
+void mipc_trace_record(uint8_t type, int conn, const void* data, size_t len) {
+    if (!g_enabled) {
+        return;
+    }
+
+    size_t payload = (type == MIPC_TRACE_RECV && data) ? len : 0;
+    size_t size = sizeof(struct mipc_trace_record_t) + payload;
+
+    if (size > MIPC_TRACE_BUFFER) {
+        g_dropped++;
+        return;
+    }
+
+    if (g_used + size > MIPC_TRACE_BUFFER && !g_mipc_trace_swap(FALSE)) {
+        g_dropped++;
+        return;
+    }
+
+    struct mipc_trace_record_t record = {
+        .time = timenow() - g_start,
+        .conn = (uint32_t)conn,
+        .len = (uint32_t)len,
+        .type = type,
+    };
+
+    char* cursor = g_buffers[g_active] + g_used;
+    memcpy(cursor, &record, sizeof(struct mipc_trace_record_t));
+
+    if (payload) {
+        memcpy(cursor + sizeof(struct mipc_trace_record_t), data, payload);
+    }
+
+    g_used += size;
+}
+
+void mipc_trace_close(void) {
+    if (!g_enabled) {
+        return;
+    }
+
+    g_enabled = FALSE;
+    g_mipc_trace_swap(TRUE);
+
+    pthread_mutex_lock(&g_lock);
+    g_stopping = TRUE;
+    pthread_cond_broadcast(&g_cond);
+    pthread_mutex_unlock(&g_lock);
+
+    pthread_join(g_writer, NULL);
+    close(g_fd);
+    g_fd = -1;
+
+    if (g_dropped) {
+        printf("[TRACE]: %llu records dropped, the writer could not keep up\n", (unsigned long long)g_dropped);
+    }
+}
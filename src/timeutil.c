@@ -0,0 +1,39 @@
+/**
+ * This file is part of the microipc distribution (https://github.com/MustafaMalikDev/microipc)
+ * Copyright (c) 2025 Mustafa Malik.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "timeutil.h"
+#include <time.h>
+
+uint64_t timenow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+
+    return (uint64_t)ts.tv_sec * MIPC_NS_PER_SEC + (uint64_t)ts.tv_nsec;
+}
+
+void timesleepuntil(uint64_t deadline) {
+    uint64_t now = timenow();
+
+    if (deadline <= now) {
+        return;
+    }
+
+    uint64_t delta = deadline - now;
+    struct timespec ts = {.tv_sec = delta / MIPC_NS_PER_SEC, .tv_nsec = delta % MIPC_NS_PER_SEC};
+
+    nanosleep(&ts, NULL);
+}
@@ -0,0 +1,292 @@
+/**
+ * This file is part of the microipc distribution (https://github.com/MustafaMalikDev/microipc)
+ * Copyright (c) 2025 Mustafa Malik.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIPC_USE_LIBS
+#define MIPC_USE_STD
+
+#include "config.h"
+#include "server/trace.h"
+#include "timeutil.h"
+
+#include <string.h>
+
+#define MIPC_REPLAY_SOCKET "/tmp/mipc.sock"
+#define MIPC_REPLAY_MAX_CONN 1024
+#define MIPC_REPLAY_CHUNK 65536
+#define MIPC_REPLAY_GONE -2 /* the kernel dropped the connection, its records are skipped until its close */
+
+static int g_sockets[MIPC_REPLAY_MAX_CONN];
+static char g_chunk[MIPC_REPLAY_CHUNK];
+
+static uint64_t* g_latencies = NULL;
+static size_t g_latency_count = 0;
+static size_t g_latency_capacity = 0;
+
+static int g_mipc_replay_connect(const char* path) {
+    struct sockaddr_un name;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd == -1) {
+        err("could not create replay socket");
+        return -1;
+    }
+
+    memset(&name, 0, sizeof(struct sockaddr_un));
+    name.sun_family = AF_UNIX;
+    name.sun_len = MIPC_SUN_SOCK_LEN + 1;
+    strncpy(name.sun_path, path, MIPC_SUN_SOCK_LEN);
+
+    if (connect(fd, (const struct sockaddr*)&name, sizeof(struct sockaddr_un)) == -1) {
+        err("could not connect to the kernel socket");
+        close(fd);
+        return -1;
+    }
+
+#ifdef SO_NOSIGPIPE
+    /* a connection the kernel dropped is skipped, writing to it must not end the replay */
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+    return fd;
+}
+
+static int g_mipc_replay_write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t written = write(fd, data, len);
+
+        if (written <= 0) {
+            return FALSE;
+        }
+
+        data += written;
+        len -= written;
+    }
+
+    return TRUE;
+}
+
+/* a recorded stamp is long stale, it goes out again with the time it is replayed at */
+static int g_mipc_replay_send(int fd, const char* frame, size_t len) {
+    char stamp[32];
+
+    if (len && *frame == 't') {
+        len = snprintf(stamp, sizeof(stamp), "t %llu", (unsigned long long)timenow());
+        frame = stamp;
+    }
+
+    return g_mipc_replay_write_all(fd, frame, len);
+}
+
+/* reads and discards exactly len bytes, the kernel's response is only timed */
+static int g_mipc_replay_drain(int fd, size_t len) {
+    while (len > 0) {
+        ssize_t got = recv(fd, g_chunk, len < MIPC_REPLAY_CHUNK ? len : MIPC_REPLAY_CHUNK, 0);
+
+        if (got <= 0) {
+            return FALSE;
+        }
+
+        len -= got;
+    }
+
+    return TRUE;
+}
+
+static void g_mipc_replay_add_latency(uint64_t latency) {
+    if (g_latency_count == g_latency_capacity) {
+        g_latency_capacity = g_latency_capacity ? g_latency_capacity * 2 : 4096;
+        g_latencies = realloc(g_latencies, g_latency_capacity * sizeof(uint64_t));
+
+        if (!g_latencies) {
+            panic("out of memory for latency samples");
+        }
+    }
+
+    g_latencies[g_latency_count++] = latency;
+}
+
+static int g_mipc_replay_compare(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+
+    return (x > y) - (x < y);
+}
+
+static double g_mipc_replay_percentile(double percentile) {
+    size_t index = (size_t)(percentile * (g_latency_count - 1));
+    return (double)g_latencies[index] / MIPC_NS_PER_USEC;
+}
+
+/*
+    mipc-replay <trace> [speed] [socket]
+
+    speed 1 replays with the recorded timing, N replays N times faster and
+    0 sends every frame as soon as the previous response arrived
+*/
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("usage: %s <trace> [speed] [socket]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    double speed = argc > 2 ? strtod(argv[2], NULL) : 1.0;
+    const char* path = argc > 3 ? argv[3] : MIPC_REPLAY_SOCKET;
+
+    FILE* trace = fopen(argv[1], "rb");
+    char magic[MIPC_TRACE_MAGIC_LEN];
+
+    if (!trace) {
+        err("could not open trace");
+        return EXIT_FAILURE;
+    }
+
+    if (fread(magic, 1, MIPC_TRACE_MAGIC_LEN, trace) != MIPC_TRACE_MAGIC_LEN ||
+        memcmp(magic, MIPC_TRACE_MAGIC, MIPC_TRACE_MAGIC_LEN) != 0) {
+        printerr("not a microipc trace file");
+        fclose(trace);
+        return EXIT_FAILURE;
+    }
+
+    for (int i = 0; i < MIPC_REPLAY_MAX_CONN; i++) {
+        g_sockets[i] = -1;
+    }
+
+    struct mipc_trace_record_t record;
+    char* payload = NULL;
+    size_t payload_capacity = 0;
+
+    uint64_t frames = 0;
+    uint64_t bytes = 0;
+    uint64_t first = 0;
+    uint64_t sent_at = 0;
+    int started = FALSE;
+    uint32_t last_conn = 0;
+    uint64_t start = timenow();
+
+    while (fread(&record, sizeof(struct mipc_trace_record_t), 1, trace) == 1) {
+        if (record.type == MIPC_TRACE_RECV) {
+            if (record.len > payload_capacity) {
+                payload_capacity = record.len;
+                payload = realloc(payload, payload_capacity);
+
+                if (!payload) {
+                    panic("out of memory for trace payload");
+                }
+            }
+
+            if (fread(payload, 1, record.len, trace) != record.len) {
+                printerr("trace is truncated");
+                break;
+            }
+        }
+
+        if (record.conn >= MIPC_REPLAY_MAX_CONN) {
+            continue;
+        }
+
+        if (speed > 0) {
+            if (!started) {
+                first = record.time;
+                start = timenow();
+                started = TRUE;
+            }
+
+            timesleepuntil(start + (uint64_t)((record.time - first) / speed));
+        }
+
+        int* fd = &g_sockets[record.conn];
+
+        if (*fd == MIPC_REPLAY_GONE && record.type != MIPC_TRACE_CLOSE) {
+            continue;
+        }
+
+        /* connections that were already open when the capture started have no open record */
+        if (*fd == -1 && record.type != MIPC_TRACE_CLOSE) {
+            *fd = g_mipc_replay_connect(path);
+
+            if (*fd == -1) {
+                break;
+            }
+        }
+
+        switch (record.type) {
+        case MIPC_TRACE_RECV:
+            if (!g_mipc_replay_send(*fd, payload, record.len)) {
+                err("could not send frame, skipping the connection");
+                close(*fd);
+                *fd = MIPC_REPLAY_GONE;
+                break;
+            }
+
+            sent_at = timenow();
+            last_conn = record.conn;
+            frames++;
+            bytes += record.len;
+            break;
+        case MIPC_TRACE_SEND:
+            if (!g_mipc_replay_drain(*fd, record.len)) {
+                printerr("kernel closed the connection before responding, skipping it");
+                close(*fd);
+                *fd = MIPC_REPLAY_GONE;
+                break;
+            }
+
+            /* only a response to the frame that was just sent is a round trip */
+            if (sent_at && record.conn == last_conn) {
+                g_mipc_replay_add_latency(timenow() - sent_at);
+                sent_at = 0;
+            }
+            break;
+        case MIPC_TRACE_CLOSE:
+            if (*fd >= 0) {
+                close(*fd);
+            }
+
+            *fd = -1;
+            break;
+        }
+    }
+
+    uint64_t elapsed = timenow() - start;
+    double seconds = (double)elapsed / MIPC_NS_PER_SEC;
+
+    for (int i = 0; i < MIPC_REPLAY_MAX_CONN; i++) {
+        if (g_sockets[i] >= 0) {
+            close(g_sockets[i]);
+        }
+    }
+
+    printf("frames:     %llu in %.3fs\n", (unsigned long long)frames, seconds);
+    printf("throughput: %.0f frames/s, %.2f MB/s\n", frames / seconds, bytes / seconds / (1024 * 1024));
+
+    if (g_latency_count) {
+        qsort(g_latencies, g_latency_count, sizeof(uint64_t), g_mipc_replay_compare);
+
+        printf("latency:    %zu round trips (us)\n", g_latency_count);
+        printf("            p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n",
+               g_mipc_replay_percentile(0.50),
+               g_mipc_replay_percentile(0.90),
+               g_mipc_replay_percentile(0.99),
+               g_mipc_replay_percentile(1.0));
+    }
+
+    free(g_latencies);
+    free(payload);
+    fclose(trace);
+    return EXIT_SUCCESS;
+}